@@ -0,0 +1,169 @@
+// build host program, NOT part of the module.
+// solves tic tac toe once and prints kg_minimax_table.h, which the module
+// uses so a perfect BOT move is a single table lookup.
+//
+// positions are indexed from the point of view of whoever is about to move:
+//   index = kg_ternary[mine] + 2 * kg_ternary[theirs]
+// where mine/theirs are the 9-bit masks from game_state.pieces, so cell i
+// is worth 3^i and is 0 = empty, 1 = mine, 2 = theirs. that way one table
+// works for X and O and for either side going first.
+//
+// it also prints the 8 board symmetries (rotations/reflections) as lookup
+// tables, which the search bot uses to canonicalize positions.
+//
+// usage: ./gen_minimax > kg_minimax_table.h
+#include <stdio.h>
+#include <string.h>
+
+#define CELLS 9
+#define POSITIONS 19683 // 3^9
+#define FULL_BOARD 0x1ff
+#define NO_MOVE 0xff
+
+static const unsigned win_masks[8] = {
+    0x007, 0x038, 0x1c0,
+    0x049, 0x092, 0x124,
+    0x111, 0x054,
+};
+
+// where cell (r, c) goes under each of the 8 symmetries, identity first
+static int sym_cell(int sym, int cell) {
+    int r = cell / 3, c = cell % 3;
+
+    switch (sym) {
+    case 0: return r * 3 + c;             // identity
+    case 1: return c * 3 + (2 - r);       // rotate 90
+    case 2: return (2 - r) * 3 + (2 - c); // rotate 180
+    case 3: return (2 - c) * 3 + r;       // rotate 270
+    case 4: return r * 3 + (2 - c);       // mirror left/right
+    case 5: return (2 - r) * 3 + c;       // mirror top/bottom
+    case 6: return c * 3 + r;             // transpose
+    default: return (2 - c) * 3 + (2 - r); // anti transpose
+    }
+}
+
+static unsigned ternary[1 << CELLS];
+static signed char memo_score[POSITIONS];
+static unsigned char memo_move[POSITIONS];
+static unsigned char memo_done[POSITIONS];
+
+static int has_line(unsigned mask) {
+    int i;
+    for (i = 0; i < 8; i++) {
+        if ((mask & win_masks[i]) == win_masks[i])
+            return 1;
+    }
+    return 0;
+}
+
+static int empty_count(unsigned occupied) {
+    return CELLS - __builtin_popcount(occupied);
+}
+
+// negamax from the side to move. a loss scores -(1 + empty cells) so the
+// bot prefers quick wins and slow losses, a draw is 0.
+static int solve(unsigned mine, unsigned theirs) {
+    unsigned idx = ternary[mine] + 2 * ternary[theirs];
+    int best = -100;
+    int best_cell = NO_MOVE;
+    int cell;
+
+    if (memo_done[idx])
+        return memo_score[idx];
+
+    if (has_line(theirs)) {
+        best = -(1 + empty_count(mine | theirs));
+    } else if ((mine | theirs) == FULL_BOARD) {
+        best = 0;
+    } else {
+        for (cell = 0; cell < CELLS; cell++) {
+            unsigned bit = 1u << cell;
+            int score;
+            if ((mine | theirs) & bit)
+                continue;
+            score = -solve(theirs, mine | bit);
+            // strictly greater, so ties go to the lowest cell
+            if (score > best) {
+                best = score;
+                best_cell = cell;
+            }
+        }
+    }
+
+    memo_done[idx] = 1;
+    memo_score[idx] = best;
+    memo_move[idx] = best_cell;
+    return best;
+}
+
+int main(void) {
+    unsigned mask, mine, theirs;
+    int i;
+
+    for (mask = 0; mask < (1 << CELLS); mask++) {
+        unsigned t = 0, p = 1;
+        for (i = 0; i < CELLS; i++, p *= 3) {
+            if (mask & (1u << i))
+                t += p;
+        }
+        ternary[mask] = t;
+    }
+
+    // every disjoint pair of masks, reachable or not, so any index the
+    // module can compute has an entry
+    for (mine = 0; mine < (1 << CELLS); mine++) {
+        for (theirs = 0; theirs < (1 << CELLS); theirs++) {
+            if (mine & theirs)
+                continue;
+            solve(mine, theirs);
+        }
+    }
+
+    printf("// generated by gen_minimax.c, do not edit\n");
+    printf("#ifndef KG_MINIMAX_TABLE_H\n#define KG_MINIMAX_TABLE_H\n\n");
+    printf("#define KG_NO_MOVE 0x%x\n\n", NO_MOVE);
+
+    printf("// 9-bit cell mask -> base 3 index with a 1 in every set cell\n");
+    printf("static const u16 kg_ternary[%d] = {", 1 << CELLS);
+    for (i = 0; i < (1 << CELLS); i++)
+        printf("%s%u,", (i % 12) ? " " : "\n    ", ternary[i]);
+    printf("\n};\n\n");
+
+    printf("// best cell (0-8) for the side to move, KG_NO_MOVE if the game is over\n");
+    printf("static const u8 kg_best_move[%d] = {", POSITIONS);
+    for (i = 0; i < POSITIONS; i++)
+        printf("%s%u,", (i % 16) ? " " : "\n    ", memo_done[i] ? memo_move[i] : NO_MOVE);
+    printf("\n};\n\n");
+
+    printf("// kg_sym[s][mask]: mask with every cell moved by symmetry s (0 = identity)\n");
+    printf("static const u16 kg_sym[8][%d] = {\n", 1 << CELLS);
+    for (i = 0; i < 8; i++) {
+        printf("    {");
+        for (mask = 0; mask < (1 << CELLS); mask++) {
+            unsigned out = 0;
+            int cell;
+            for (cell = 0; cell < CELLS; cell++) {
+                if (mask & (1u << cell))
+                    out |= 1u << sym_cell(i, cell);
+            }
+            printf("%s%u,", (mask % 12) ? " " : "\n        ", out);
+        }
+        printf("\n    },\n");
+    }
+    printf("};\n\n");
+
+    printf("// kg_sym_inv[s][cell]: cell that symmetry s moves onto cell\n");
+    printf("static const u8 kg_sym_inv[8][%d] = {\n", CELLS);
+    for (i = 0; i < 8; i++) {
+        int cell, from;
+        printf("    {");
+        for (cell = 0; cell < CELLS; cell++) {
+            for (from = 0; sym_cell(i, from) != cell; from++)
+                ;
+            printf("%s%d", cell ? ", " : "", from);
+        }
+        printf("},\n");
+    }
+    printf("};\n\n#endif\n");
+    return 0;
+}
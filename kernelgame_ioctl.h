@@ -0,0 +1,168 @@
+// binary interface to /dev/wtictactoe, shared between the module and
+// userspace clients. one ioctl per command, each returns the result code and
+// the whole game state in the same call, so no parsing and no extra read.
+//
+//   struct kg_ioc_cmd c = { .row = 2, .col = 2 };
+//   ioctl(fd, KG_IOC_PLAY, &c);
+//   if (c.code == KG_OK) ...
+//
+// the ioctl itself returns 0 whenever the command reached the game, even if
+// the game said no, check .code for that. -1/errno is only for bad pointers
+// or unknown ioctls.
+//
+// GET_BOARD and GET_BOARD_EX dont wait for a command thats running on the
+// same file, they return the game as of the last finished one.
+#ifndef _KERNELGAME_IOCTL_H
+#define _KERNELGAME_IOCTL_H
+
+#include <linux/ioctl.h>
+#include <linux/types.h>
+
+// same values and order as RETURN_CODES / return_code_messages in kg_engine.h/.c
+enum kg_result {
+    KG_OK = 0,
+    KG_MISSING_PIECE,
+    KG_INVALID_PIECE,
+    KG_GAME_STARTED,
+    KG_INVALID_RESET,
+    KG_GAME_NOT_STARTED,
+    KG_NOT_PLAYER_TURN,
+    KG_OUT_OF_BOUNDS,
+    KG_CANNOT_PLACE,
+    KG_GAME_OVER,
+    KG_INVALID_BOT,
+    KG_NOT_CPU_TURN,
+    KG_DEV_INVALID_COMMAND,
+    KG_SIM_RUNNING,       // KG_IOC_SIMULATE while the last one is still going
+};
+
+// snapshot of one game
+struct kg_ioc_state {
+    __u16 x_mask;         // bit (row * 3 + col), rows/cols 0 based, set where X played. 3x3 boards only, 0 otherwise
+    __u16 o_mask;         // same for O
+    __u8 current_piece;   // 'X', 'O', '?' before START. piece that moves next
+    __u8 current_player;  // 'P' (player), 'B' (bot), '?' before START
+    __u8 game_started;
+    __u8 game_over;
+    __u8 winner;          // 'X', 'O', 'D' for draw, '?' while playing
+    __u8 pad[3];
+};
+
+struct kg_ioc_cmd {
+    // in
+    __u8 piece;           // START: 'X' or 'O'
+    __u8 row;             // PLAY: 1-board_size, same as the text command
+    __u8 col;             // PLAY: 1-board_size
+    __u8 pad;
+    // out
+    __s32 code;           // enum kg_result
+    struct kg_ioc_state state;
+};
+
+// the board on any size the module was loaded with (board_size=, win_length=)
+#define KG_IOC_MAX_BOARD 16
+
+struct kg_ioc_board {
+    __u8 board_size;      // N, 3-16
+    __u8 win_length;      // K in a row wins
+    __u16 num_moves;
+    __u16 x_rows[KG_IOC_MAX_BOARD]; // bit col of x_rows[row] set where X played, 0 based
+    __u16 o_rows[KG_IOC_MAX_BOARD]; // same for O
+};
+
+// bot vs bot games run by the module, spread over every cpu. SIMULATE
+// returns right away, then ask SIM_RESULT (or poll it) until running is 0.
+// the text version is "SIMULATE <games>", its result shows up as a reply
+// line "SIMULATED <games> X <x wins> O <o wins> D <draws> <n> games/s"
+struct kg_ioc_sim {
+    __u32 games;          // in: SIMULATE, 1-100000000. out: what the last run asked for
+    __s32 code;           // SIMULATE: KG_OK, KG_SIM_RUNNING or KG_DEV_INVALID_COMMAND
+    __u32 running;        // last run still going
+    __u32 pad;
+    __u64 played;         // games finished so far
+    __u64 x_wins;         // X always moves first
+    __u64 o_wins;
+    __u64 draws;
+    __u64 elapsed_ns;     // whole run, 0 while running
+    __u64 games_per_sec;  // 0 while running
+};
+
+// what mmap() of the device gives you: one read-only page per open file
+// holding the live game, updated by the module after every command.
+//
+//   struct kg_shared_state *sh = mmap(NULL, 4096, PROT_READ, MAP_SHARED, fd, 0);
+//   do {
+//       seq = sh->seq;               // (+ a read barrier)
+//       snap = sh->state;
+//   } while ((seq & 1) || seq != sh->seq);
+//
+// seq is odd while an update is in progress and goes up by 2 per update, so
+// it also tells you if anything changed since you last looked.
+// version 2 added board, version 1 clients just dont look past state
+#define KG_SHARED_VERSION 2
+
+struct kg_shared_state {
+    __u32 seq;
+    __u32 version;        // KG_SHARED_VERSION
+    struct kg_ioc_state state;
+    struct kg_ioc_board board;
+};
+
+// checkpoint of every live game, so games survive an rmmod/insmod. read
+// /sys/kernel/debug/wtictactoe/checkpoint for one kg_ckpt_header and then
+// a kg_ckpt_record per started game, write the same bytes back after the
+// reload and each game waits there until a new open claims it with
+// KG_IOC_RESUME and its id. native byte order, its meant for the box that
+// wrote it. anything that changes a record bumps KG_CKPT_VERSION
+#define KG_CKPT_MAGIC 0x504b434b // "KCKP" in memory on little endian
+#define KG_CKPT_VERSION 1
+
+struct kg_ckpt_header {
+    __u32 magic;          // KG_CKPT_MAGIC
+    __u16 version;        // KG_CKPT_VERSION
+    __u16 record_size;    // sizeof(struct kg_ckpt_record)
+    __u8 board_size;      // restore needs the same board_size/win_length
+    __u8 win_length;
+    __u8 pad[6];
+};
+
+struct kg_ckpt_record {
+    __u64 id;             // KG_IOC_GAME_ID of the file it was played on
+    __u64 age_ns;         // time since START
+    __u64 moves;          // 3x3 move list, 4 bits per move in play order. 0 past 3x3
+    __u16 node;           // minor of the device node, only that node can claim it
+    __u16 num_moves;
+    __u8 current_piece;   // same meaning as in kg_ioc_state
+    __u8 current_player;
+    __u8 game_over;
+    __u8 winner;
+    __u8 pad[8];
+    __u16 x_rows[KG_IOC_MAX_BOARD]; // same as kg_ioc_board
+    __u16 o_rows[KG_IOC_MAX_BOARD];
+};
+
+#define KG_IOC_MAGIC 'T'
+
+#define KG_IOC_START     _IOWR(KG_IOC_MAGIC, 1, struct kg_ioc_cmd)
+#define KG_IOC_PLAY      _IOWR(KG_IOC_MAGIC, 2, struct kg_ioc_cmd)
+#define KG_IOC_BOT       _IOWR(KG_IOC_MAGIC, 3, struct kg_ioc_cmd)
+#define KG_IOC_RESET     _IOWR(KG_IOC_MAGIC, 4, struct kg_ioc_cmd)
+#define KG_IOC_GET_BOARD _IOR(KG_IOC_MAGIC, 5, struct kg_ioc_cmd)
+#define KG_IOC_GET_BOARD_EX _IOR(KG_IOC_MAGIC, 6, struct kg_ioc_board)
+#define KG_IOC_SIMULATE  _IOWR(KG_IOC_MAGIC, 7, struct kg_ioc_sim)
+#define KG_IOC_SIM_RESULT _IOR(KG_IOC_MAGIC, 8, struct kg_ioc_sim)
+// 1 puts "<seq> " in front of every text reply queued on this file from
+// then on, 0 (the default) turns it off again. replies already waiting
+// keep what they were queued with. seq counts the command lines written to the file,
+// from 1, so pipelined clients can match replies to writes. BOARD then
+// replies "<seq> BOARD" with the board on the lines after it
+#define KG_IOC_REPLY_SEQ _IOW(KG_IOC_MAGIC, 9, __u32)
+// id of the game on this file, random per open. keep it to get the game
+// back after a checkpoint and reload
+#define KG_IOC_GAME_ID   _IOR(KG_IOC_MAGIC, 10, __u64)
+// take over a restored game by id, on a file whose game hasnt started. the
+// file gets that id from then on. ENOENT if no restored game has it (or it
+// was on another node), EBUSY if this files game already started
+#define KG_IOC_RESUME    _IOW(KG_IOC_MAGIC, 11, __u64)
+
+#endif /* _KERNELGAME_IOCTL_H */
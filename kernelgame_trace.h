@@ -0,0 +1,80 @@
+// tracepoints for the tictactoe module, these are what to use instead of
+// dmesg when looking at whats going on. always compiled in, cost nothing
+// until enabled:
+//   echo 1 > /sys/kernel/tracing/events/kernelgame/enable
+//   cat /sys/kernel/tracing/trace_pipe
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM kernelgame
+
+#if !defined(_KERNELGAME_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _KERNELGAME_TRACE_H
+
+#include <linux/tracepoint.h>
+
+// a command line came in through write()
+TRACE_EVENT(kg_command_received,
+    TP_PROTO(const char *command),
+    TP_ARGS(command),
+    TP_STRUCT__entry(
+        __string(command, command)
+    ),
+    TP_fast_assign(
+        __assign_str(command, command);
+    ),
+    TP_printk("command=%s", __get_str(command))
+);
+
+// a piece landed on the board, row/col are 1 based like the PLAY command
+TRACE_EVENT(kg_move_applied,
+    TP_PROTO(char piece, int row, int col, bool bot),
+    TP_ARGS(piece, row, col, bot),
+    TP_STRUCT__entry(
+        __field(char, piece)
+        __field(int, row)
+        __field(int, col)
+        __field(bool, bot)
+    ),
+    TP_fast_assign(
+        __entry->piece = piece;
+        __entry->row = row;
+        __entry->col = col;
+        __entry->bot = bot;
+    ),
+    TP_printk("%s placed %c at (%d, %d)", __entry->bot ? "bot" : "player",
+              __entry->piece, __entry->row, __entry->col)
+);
+
+// winner is 'X', 'O' or 'D' for a draw
+TRACE_EVENT(kg_game_over,
+    TP_PROTO(char winner),
+    TP_ARGS(winner),
+    TP_STRUCT__entry(
+        __field(char, winner)
+    ),
+    TP_fast_assign(
+        __entry->winner = winner;
+    ),
+    TP_printk("winner=%c", __entry->winner)
+);
+
+// command line was rejected before reaching a handler
+TRACE_EVENT(kg_parse_error,
+    TP_PROTO(const char *reason),
+    TP_ARGS(reason),
+    TP_STRUCT__entry(
+        __string(reason, reason)
+    ),
+    TP_fast_assign(
+        __assign_str(reason, reason);
+    ),
+    TP_printk("reason=%s", __get_str(reason))
+);
+
+#endif /* _KERNELGAME_TRACE_H */
+
+// has to be outside the include guard
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE kernelgame_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,169 @@
+// userspace microbenchmarks for the game engine, links libkgengine.a so no
+// module or root is needed (runs fine in CI).
+//
+// usage: ./kg_bench [iterations [board_size win_length]]
+//   (default 5000000 on 3x3)
+// prints one "name ns/op" line per benchmark. past 3x3 every bot is the
+// random one and every copied position drags its line words along
+#include <stdio.h>
+#include <stdlib.h>
+#include "kg_engine.h"
+
+// results land here so the compiler cant drop the work
+static volatile unsigned long sink;
+
+// some positions to spread the work over, built by playing games out
+#define NUM_POSITIONS 64
+static struct game_state positions[NUM_POSITIONS];   // player to move, game not over
+static struct game_state bot_turns[NUM_POSITIONS];   // bot to move, game not over
+static struct kg_lines position_lines[NUM_POSITIONS];
+static struct kg_lines bot_turn_lines[NUM_POSITIONS];
+static int free_cell[NUM_POSITIONS];                 // somewhere positions[i] can play
+static int last_cell[NUM_POSITIONS];                 // what got played to make bot_turns[i]
+
+static const char * const parse_lines[] = {
+    "START X", "PLAY 2 3", "BOT", "RESET", "BOARD", "PLAY 1 1", "START O", "BOGUS 1",
+};
+#define NUM_LINES (sizeof(parse_lines) / sizeof(parse_lines[0]))
+
+static void build_positions(void) {
+    unsigned int n = kg_board_size;
+    struct kg_lines lines;
+    int i = 0;
+
+    while (i < NUM_POSITIONS) {
+        struct game_state game;
+
+        game_init(&game, &lines);
+        game_start(&game, (i & 1) ? 'O' : 'X');
+        // random depth so the set has early, mid and late boards
+        int moves = get_random_u32_below(n * n / 2 - 1);
+        while (moves-- > 0 && !game.game_over) {
+            int cell = random_bot_cell(&game);
+            if (game_play(&game, cell / n, cell % n) != OK)
+                break;
+            if (game_bot(&game) != OK)
+                break;
+        }
+        if (game.game_over || game.current_player != 'P')
+            continue;
+        game_copy(&positions[i], &position_lines[i], &game);
+        game_copy(&bot_turns[i], &bot_turn_lines[i], &game);
+        int cell = random_bot_cell(&game);
+        if (game_play(&bot_turns[i], cell / n, cell % n) != OK || bot_turns[i].game_over)
+            continue;
+        free_cell[i] = cell;
+        last_cell[i] = cell;
+        i++;
+    }
+}
+
+static void report(const char *name, u64 start, unsigned long iters) {
+    printf("%-16s %8.2f ns/op\n", name, (double)(ktime_get_ns() - start) / iters);
+}
+
+static void bench_parse(unsigned long iters) {
+    struct parsed_command cmd;
+    unsigned long i;
+    u64 start = ktime_get_ns();
+
+    for (i = 0; i < iters; i++)
+        sink += parse_command(parse_lines[i % NUM_LINES], &cmd) + cmd.args[0];
+    report("parse", start, iters);
+}
+
+// copy a position in and play a free cell, includes the win check
+// game_play does itself
+static void bench_move_apply(unsigned long iters) {
+    struct game_state game;
+    struct kg_lines lines;
+    unsigned long i;
+    u64 start = ktime_get_ns();
+
+    for (i = 0; i < iters; i++) {
+        int p = i % NUM_POSITIONS;
+
+        game_copy(&game, &lines, &positions[p]);
+        sink += game_play(&game, free_cell[p] / kg_board_size, free_cell[p] % kg_board_size);
+    }
+    report("move_apply", start, iters);
+}
+
+static void bench_win_check(unsigned long iters) {
+    unsigned long i;
+    u64 start = ktime_get_ns();
+
+    for (i = 0; i < iters; i++) {
+        int p = i % NUM_POSITIONS;
+
+        sink += check_win(&bot_turns[p], (i & 1) ? 'O' : 'X',
+                          last_cell[p] / kg_board_size, last_cell[p] % kg_board_size);
+    }
+    report("win_check", start, iters);
+}
+
+static void bench_bot(const char *name, int mode, unsigned long iters) {
+    struct game_state game;
+    struct kg_lines lines;
+    unsigned long i;
+    u64 start;
+
+    kg_bot_mode = mode;
+    start = ktime_get_ns();
+    for (i = 0; i < iters; i++) {
+        game_copy(&game, &lines, &bot_turns[i % NUM_POSITIONS]);
+        sink += game_bot(&game);
+    }
+    report(name, start, iters);
+    kg_bot_mode = KG_BOT_RANDOM;
+}
+
+// whole bot vs bot games like SIMULATE plays, one per op
+static void bench_self_play(unsigned long iters) {
+    unsigned long i;
+    u64 start = ktime_get_ns();
+
+    iters = iters / 16 + 1;
+    for (i = 0; i < iters; i++)
+        sink += kg_self_play(KG_BOT_RANDOM);
+    report("self_play", start, iters);
+}
+
+static void bench_render(unsigned long iters) {
+    char buffer[KG_BOARD_TEXT_MAX];
+    unsigned long i;
+    u64 start = ktime_get_ns();
+
+    for (i = 0; i < iters; i++) {
+        sink += print_board_to_buffer(&bot_turns[i % NUM_POSITIONS], buffer, sizeof(buffer));
+        sink += buffer[i % kg_board_text_len];
+    }
+    report("render", start, iters);
+}
+
+int main(int argc, char **argv) {
+    unsigned long iters = 5000000;
+
+    if (argc > 1)
+        iters = strtoul(argv[1], NULL, 0);
+    if (!iters || argc == 3 || argc > 4 ||
+        (argc == 4 && kg_engine_setup(atoi(argv[2]), atoi(argv[3])))) {
+        fprintf(stderr, "usage: %s [iterations [board_size win_length]]\n", argv[0]);
+        return 1;
+    }
+
+    build_positions();
+    bench_parse(iters);
+    bench_move_apply(iters);
+    bench_win_check(iters);
+    bench_bot("bot_random", KG_BOT_RANDOM, iters);
+    if (kg_classic()) {
+        bench_bot("bot_perfect", KG_BOT_PERFECT, iters);
+        bench_bot("bot_search", KG_BOT_SEARCH, iters);
+    }
+    if (kg_stats.tt_lookups)
+        printf("%-16s %8.2f %%\n", "tt_hit_rate", 100.0 * kg_stats.tt_hits / kg_stats.tt_lookups);
+    bench_render(iters);
+    bench_self_play(iters);
+    return 0;
+}
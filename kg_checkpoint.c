@@ -0,0 +1,470 @@
+// checkpoint/restore, so an rmmod/insmod (driver upgrade) doesnt cost every
+// game in progress.
+//
+// a game lives as long as its open file and an open file pins the module,
+// so by the time the module can go nothing is being played anymore. the
+// checkpoint is taken before that instead, while clients are still on:
+//   cat /sys/kernel/debug/wtictactoe/checkpoint > games.kgc
+//   (clients close, rmmod, insmod the new module)
+//   cat games.kgc > /sys/kernel/debug/wtictactoe/checkpoint
+// then every client opens again and takes its game back with KG_IOC_RESUME
+// and the id KG_IOC_GAME_ID gave it. restored games nobody claimed yet are
+// parked here, and go into the next checkpoint too so a second reload
+// doesnt lose them.
+//
+// a claim can race a dump, which walks the parked games first and the live
+// ones after. a claimed game stays parked until its session has published
+// it, so whichever way they interleave the dump sees it in at least one
+// place. seen in both, the live one comes later and a restore keeps the
+// last record for an id.
+//
+// the format (kernelgame_ioctl.h) is a header and then one fixed size
+// record per game. a dump walks the game tables with a cursor and builds
+// one record at a time, a restore parses records as they come in, so
+// neither side needs a buffer for the whole table no matter how many games
+// there are or how the bytes get split over read/write calls
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/hashtable.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include "kg_checkpoint.h"
+
+// a restored game waiting for its client
+struct kg_parked {
+    struct hlist_node hash;     // in kg_parked_ids, by id
+    unsigned int index;         // in kg_parked_table
+    bool claimed;               // handed to a session that hasnt published it yet
+    struct kg_ckpt_record rec;
+};
+
+#define KG_PARKED_HASH_BITS 10
+static DEFINE_HASHTABLE(kg_parked_ids, KG_PARKED_HASH_BITS);
+static struct kg_parked **kg_parked_table; // dump order, NULL where its been claimed
+static unsigned int kg_parked_max;
+static unsigned int kg_nr_nodes;           // device nodes this load has, a record for another one cant be claimed
+static unsigned int kg_parked_next;        // where to look for a free entry first
+static unsigned int kg_parked_count;       // entries in the table, claimed ones included
+static DEFINE_MUTEX(kg_parked_lock);       // everything kg_parked_*
+
+// one per open of the debugfs file. an open either reads (dump) or writes
+// (restore), never both
+struct kg_ckpt_file {
+    struct mutex lock;          // two threads on one fd take turns
+    bool header_done;           // header handed out / checked
+    bool parked_done;           // dump: parked games done, on to the game tables
+    unsigned long cursor;       // dump: next parked index, then game table index
+    int error;                  // restore: first bad header/record, later writes get it too
+    unsigned int restored;      // restore: games parked so far
+    size_t have;                // restore: how much of buf is filled
+    union {
+        struct kg_ckpt_header header;
+        struct kg_ckpt_record rec;
+    } buf;
+};
+
+void kg_checkpoint_encode(struct kg_ckpt_record *rec, u64 id, unsigned int node,
+                          const struct game_state *game) {
+    unsigned int r;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->id = id;
+    rec->age_ns = ktime_get_ns() - game->start_ns;
+    rec->moves = game->moves;
+    rec->node = node;
+    rec->num_moves = game->num_moves;
+    rec->current_piece = game->current_piece;
+    rec->current_player = game->current_player;
+    rec->game_over = game->game_over;
+    rec->winner = game->winner;
+    for (r = 0; r < kg_board_size; r++) {
+        rec->x_rows[r] = board_row(game, 0, r);
+        rec->o_rows[r] = board_row(game, 1, r);
+    }
+}
+
+// does one piece have kg_win_length in a row anywhere. rows in the
+// board_row layout, every line through row r is looked for at once by
+// anding the k rows from r down, shifted so the cells of a line line up
+static bool rows_have_line(const u16 *rows) {
+    unsigned int n = kg_board_size, k = kg_win_length, r, i;
+
+    for (r = 0; r < n; r++) {
+        u32 across = rows[r], down = rows[r], diag = rows[r], anti = rows[r];
+
+        for (i = 1; i < k; i++) {
+            across &= rows[r] >> i;
+            if (r + i < n) {
+                down &= rows[r + i];
+                diag &= rows[r + i] >> i;
+                anti &= (u32)rows[r + i] << i;
+            } else {
+                down = diag = anti = 0;
+            }
+        }
+        if (across | down | diag | anti)
+            return true;
+    }
+    return false;
+}
+
+// 3x3 keeps the move list for the history file, it has to play out to the
+// board: every cell once, pieces taking turns so the last move is last's,
+// and nobody done before the last move
+static bool moves_valid(const struct kg_ckpt_record *rec, char last) {
+    u16 rows[2][KG_MAX_BOARD] = { { 0 } };
+    unsigned int i, p, cell;
+
+    for (i = 0; i < rec->num_moves; i++) {
+        cell = (rec->moves >> (4 * i)) & 0xf;
+        if (cell > 8 || ((rows[0][cell / 3] | rows[1][cell / 3]) & (1u << (cell % 3))))
+            return false;
+        p = piece_index((rec->num_moves - 1 - i) % 2 ? (last == 'X' ? 'O' : 'X') : last);
+        if (i && rows_have_line(rows[!p]))
+            return false;
+        rows[p][cell / 3] |= 1u << (cell % 3);
+    }
+    if (rec->moves >> (4 * rec->num_moves))
+        return false;
+    return !memcmp(rows[0], rec->x_rows, sizeof(rows[0])) && !memcmp(rows[1], rec->o_rows, sizeof(rows[1]));
+}
+
+// the file comes from userspace, so a record has to be a started game the
+// rules could have got to before its parked, or the engine ends up with a
+// board it never expects (a line nobody noticed, the wrong side to move)
+static bool record_valid(const struct kg_ckpt_record *rec) {
+    unsigned int n = kg_board_size, r, x = 0, o = 0;
+    u16 row_mask = (1u << n) - 1;
+    bool x_line, o_line;
+    char last;
+
+    // nobody could ever claim it, it would just take up a parked entry
+    if (rec->node >= kg_nr_nodes)
+        return false;
+    // started before boot (another machine, an old checkpoint), start_ns
+    // would wrap
+    if (rec->age_ns > ktime_get_ns())
+        return false;
+    if (rec->current_piece != 'X' && rec->current_piece != 'O')
+        return false;
+    if (rec->current_player != 'P' && rec->current_player != 'B')
+        return false;
+    if (rec->game_over > 1)
+        return false;
+    if (rec->game_over ? rec->winner != 'X' && rec->winner != 'O' && rec->winner != 'D' :
+                         rec->winner != '?')
+        return false;
+    for (r = 0; r < KG_MAX_BOARD; r++) {
+        u16 both = rec->x_rows[r] | rec->o_rows[r];
+
+        if ((rec->x_rows[r] & rec->o_rows[r]) || (r < n ? both & ~row_mask : both))
+            return false;
+        x += hweight16(rec->x_rows[r]);
+        o += hweight16(rec->o_rows[r]);
+    }
+    if (x + o != rec->num_moves || x > o + 1 || o > x + 1)
+        return false;
+    x_line = rows_have_line(rec->x_rows);
+    o_line = rows_have_line(rec->o_rows);
+
+    // the player always moves first and the sides take turns, so the turn
+    // follows from num_moves and the piece from the counts (with x == o
+    // either piece could have opened). a finished game stays on B with
+    // current_piece the one that moved last
+    if (rec->game_over) {
+        last = rec->current_piece;
+        if (rec->current_player != 'B')
+            return false;
+        if (rec->winner == 'D' ? x_line || o_line || rec->num_moves != n * n :
+            rec->winner != last || !(last == 'X' ? x_line : o_line) || (last == 'X' ? o_line : x_line))
+            return false;
+    } else {
+        last = rec->current_piece == 'X' ? 'O' : 'X';
+        if (x_line || o_line || rec->num_moves == n * n)
+            return false;
+        if (rec->current_player != (rec->num_moves % 2 ? 'B' : 'P'))
+            return false;
+    }
+    if ((x > o && last != 'X') || (o > x && last != 'O'))
+        return false;
+
+    if (!kg_classic())
+        return !rec->moves;
+    return moves_valid(rec, last);
+}
+
+static int check_header(const struct kg_ckpt_header *h) {
+    if (h->magic != KG_CKPT_MAGIC || h->version != KG_CKPT_VERSION ||
+        h->record_size != sizeof(struct kg_ckpt_record)) {
+        printk(KERN_ERR "checkpoint: not a version %u checkpoint\n", KG_CKPT_VERSION);
+        return -EINVAL;
+    }
+    if (h->board_size != kg_board_size || h->win_length != kg_win_length) {
+        printk(KERN_ERR "checkpoint: taken on %ux%u, %u in a row, but this is %ux%u, %u in a row\n",
+               h->board_size, h->board_size, h->win_length, kg_board_size, kg_board_size, kg_win_length);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+// caller holds kg_parked_lock
+static struct kg_parked *find_parked(u64 id) {
+    struct kg_parked *p;
+
+    hash_for_each_possible(kg_parked_ids, p, hash, id) {
+        if (p->rec.id == id)
+            return p;
+    }
+    return NULL;
+}
+
+static int park(const struct kg_ckpt_record *rec) {
+    struct kg_parked *p, *old;
+    int ret = 0;
+
+    if (!record_valid(rec))
+        return -EINVAL;
+    p = kmalloc(sizeof(*p), GFP_KERNEL);
+    if (!p)
+        return -ENOMEM;
+    p->rec = *rec;
+    p->claimed = false;
+
+    mutex_lock(&kg_parked_lock);
+    // same checkpoint written twice, the game is already waiting. last
+    // record wins, a dump has the live copy of a game after the parked one
+    old = find_parked(rec->id);
+    if (old) {
+        if (!old->claimed)
+            old->rec = *rec;
+        kfree(p);
+        goto out;
+    }
+    if (kg_parked_count == kg_parked_max) {
+        kfree(p);
+        ret = -ENOSPC;
+        goto out;
+    }
+    // theres a free entry somewhere, claims leave holes behind
+    while (kg_parked_table[kg_parked_next % kg_parked_max])
+        kg_parked_next++;
+    p->index = kg_parked_next % kg_parked_max;
+    kg_parked_next = p->index + 1;
+    kg_parked_table[p->index] = p;
+    hash_add(kg_parked_ids, &p->hash, rec->id);
+    kg_parked_count++;
+out:
+    mutex_unlock(&kg_parked_lock);
+    return ret;
+}
+
+int kg_checkpoint_claim(u64 id, unsigned int node, struct game_state *game, struct kg_lines *lines) {
+    struct kg_parked *p;
+
+    mutex_lock(&kg_parked_lock);
+    p = find_parked(id);
+    // a game can only come back on the node it was played on
+    if (!p || p->claimed || p->rec.node != node) {
+        mutex_unlock(&kg_parked_lock);
+        return -ENOENT;
+    }
+    // stays in the table for dumps until kg_checkpoint_claimed
+    p->claimed = true;
+    mutex_unlock(&kg_parked_lock);
+
+    game_init(game, lines);
+    game_set_rows(game, p->rec.x_rows, p->rec.o_rows);
+    game->current_piece = p->rec.current_piece;
+    game->current_player = p->rec.current_player;
+    game->game_started = true;
+    game->game_over = p->rec.game_over;
+    game->winner = p->rec.winner;
+    game->num_moves = p->rec.num_moves;
+    game->moves = p->rec.moves;
+    // the time it spent checkpointed doesnt count towards the game
+    game->start_ns = ktime_get_ns() - p->rec.age_ns;
+    return 0;
+}
+
+void kg_checkpoint_claimed(u64 id) {
+    struct kg_parked *p;
+
+    mutex_lock(&kg_parked_lock);
+    p = find_parked(id);
+    if (p && p->claimed) {
+        hash_del(&p->hash);
+        kg_parked_table[p->index] = NULL;
+        kg_parked_count--;
+        kfree(p);
+    }
+    mutex_unlock(&kg_parked_lock);
+}
+
+unsigned int kg_checkpoint_parked(void) {
+    return READ_ONCE(kg_parked_count);
+}
+
+// next record for a dump, parked games first (claimed ones too, see the
+// top of the file), then the live ones
+static bool next_record(struct kg_ckpt_file *f, struct kg_ckpt_record *rec) {
+    bool found = false;
+
+    if (!f->parked_done) {
+        mutex_lock(&kg_parked_lock);
+        for (; f->cursor < kg_parked_max; f->cursor++) {
+            if (kg_parked_table[f->cursor]) {
+                *rec = kg_parked_table[f->cursor++]->rec;
+                found = true;
+                break;
+            }
+        }
+        mutex_unlock(&kg_parked_lock);
+        if (found)
+            return true;
+        f->parked_done = true;
+        f->cursor = 0;
+    }
+    return kg_checkpoint_live(&f->cursor, rec);
+}
+
+// header first, then as many whole records as fit. 0 (EOF) once every game
+// is out
+static ssize_t kg_checkpoint_read(struct file *filp, char __user *buf, size_t count, loff_t *ppos)
+{
+    struct kg_ckpt_file *f = filp->private_data;
+    struct kg_ckpt_record rec;
+    ssize_t done = 0;
+
+    // never half a record, so a dump is always clean to write back
+    if (count < sizeof(rec))
+        return -EINVAL;
+    if (mutex_lock_interruptible(&f->lock))
+        return -ERESTARTSYS;
+    if (!f->header_done) {
+        struct kg_ckpt_header header;
+
+        BUILD_BUG_ON(sizeof(header) > sizeof(rec));
+        memset(&header, 0, sizeof(header));
+        header.magic = KG_CKPT_MAGIC;
+        header.version = KG_CKPT_VERSION;
+        header.record_size = sizeof(rec);
+        header.board_size = kg_board_size;
+        header.win_length = kg_win_length;
+        if (copy_to_user(buf, &header, sizeof(header))) {
+            done = -EFAULT;
+            goto out;
+        }
+        f->header_done = true;
+        done = sizeof(header);
+    }
+    while (count - done >= sizeof(rec) && next_record(f, &rec)) {
+        if (copy_to_user(buf + done, &rec, sizeof(rec))) {
+            if (!done)
+                done = -EFAULT;
+            goto out;
+        }
+        done += sizeof(rec);
+    }
+out:
+    mutex_unlock(&f->lock);
+    return done;
+}
+
+// takes the bytes in any chunks, every record thats complete gets parked
+// right away. a bad header or record stops the restore there, whatever was
+// parked before it stays
+static ssize_t kg_checkpoint_write(struct file *filp, const char __user *buf, size_t count, loff_t *ppos)
+{
+    struct kg_ckpt_file *f = filp->private_data;
+    size_t done = 0, want, n;
+    ssize_t ret;
+
+    if (mutex_lock_interruptible(&f->lock))
+        return -ERESTARTSYS;
+    while (done < count && !f->error) {
+        want = f->header_done ? sizeof(f->buf.rec) : sizeof(f->buf.header);
+        n = min(count - done, want - f->have);
+        if (copy_from_user((u8 *)&f->buf + f->have, buf + done, n)) {
+            ret = done ? done : -EFAULT;
+            goto out;
+        }
+        f->have += n;
+        done += n;
+        if (f->have < want)
+            break;
+        f->have = 0;
+        if (!f->header_done) {
+            f->error = check_header(&f->buf.header);
+            f->header_done = true;
+        } else {
+            f->error = park(&f->buf.rec);
+            if (!f->error)
+                f->restored++;
+        }
+    }
+    ret = f->error ? f->error : done;
+out:
+    mutex_unlock(&f->lock);
+    return ret;
+}
+
+static int kg_checkpoint_open(struct inode *inode, struct file *filp)
+{
+    struct kg_ckpt_file *f;
+
+    if ((filp->f_mode & FMODE_READ) && (filp->f_mode & FMODE_WRITE))
+        return -EINVAL;
+    f = kzalloc(sizeof(*f), GFP_KERNEL);
+    if (!f)
+        return -ENOMEM;
+    mutex_init(&f->lock);
+    filp->private_data = f;
+    return nonseekable_open(inode, filp);
+}
+
+static int kg_checkpoint_release(struct inode *inode, struct file *filp)
+{
+    struct kg_ckpt_file *f = filp->private_data;
+
+    if (filp->f_mode & FMODE_WRITE) {
+        if (f->have)
+            printk(KERN_WARNING "checkpoint: file ended %zu bytes into a record, dropped it\n", f->have);
+        printk(KERN_INFO "checkpoint: %u games restored, %u waiting for KG_IOC_RESUME\n",
+               f->restored, kg_checkpoint_parked());
+    }
+    kfree(f);
+    return 0;
+}
+
+const struct file_operations kg_checkpoint_fops = {
+    .owner = THIS_MODULE,
+    .open = kg_checkpoint_open,
+    .read = kg_checkpoint_read,
+    .write = kg_checkpoint_write,
+    .release = kg_checkpoint_release,
+};
+
+int kg_checkpoint_init(unsigned int nr_nodes, unsigned int max_parked) {
+    kg_parked_table = kvcalloc(max_parked, sizeof(*kg_parked_table), GFP_KERNEL);
+    if (!kg_parked_table)
+        return -ENOMEM;
+    kg_parked_max = max_parked;
+    kg_nr_nodes = nr_nodes;
+    return 0;
+}
+
+void kg_checkpoint_exit(void) {
+    unsigned int i;
+
+    if (kg_parked_count)
+        printk(KERN_INFO "checkpoint: %u restored games were never claimed\n", kg_parked_count);
+    for (i = 0; i < kg_parked_max; i++)
+        kfree(kg_parked_table[i]);
+    kvfree(kg_parked_table);
+    hash_init(kg_parked_ids);
+    kg_parked_table = NULL;
+    kg_parked_max = 0;
+    kg_parked_count = 0;
+}
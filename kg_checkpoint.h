@@ -0,0 +1,30 @@
+// checkpoint/restore of live games across a module reload, see kg_checkpoint.c
+#ifndef KG_CHECKPOINT_H
+#define KG_CHECKPOINT_H
+
+#include <linux/fs.h>
+#include <linux/types.h>
+#include "kernelgame_ioctl.h"
+#include "kg_engine.h"
+
+extern const struct file_operations kg_checkpoint_fops; // the debugfs "checkpoint" file
+
+// provided by kg_main.c: the next started game at or after *index in the
+// game tables, false once there are no more. *index ends up past it
+bool kg_checkpoint_live(unsigned long *index, struct kg_ckpt_record *rec);
+
+void kg_checkpoint_encode(struct kg_ckpt_record *rec, u64 id, unsigned int node,
+                          const struct game_state *game);
+// hand the restored game with this id over to game (a fresh one), -ENOENT
+// if theres none for that node. it stays in dumps until the caller has
+// published game and called kg_checkpoint_claimed
+int kg_checkpoint_claim(u64 id, unsigned int node, struct game_state *game, struct kg_lines *lines);
+void kg_checkpoint_claimed(u64 id);
+unsigned int kg_checkpoint_parked(void);
+
+// nr_nodes: device nodes, records for any other are refused
+// max_parked: how many restored games can wait to be claimed at once
+int kg_checkpoint_init(unsigned int nr_nodes, unsigned int max_parked);
+void kg_checkpoint_exit(void);
+
+#endif
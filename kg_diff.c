@@ -0,0 +1,509 @@
+// differential checker: runs the engine next to a dumb reference model of
+// the rules (a char per cell, runs counted by walking out from the last
+// move) and compares the two after every step. links libkgengine.a, no
+// module or root needed.
+//
+// usage: ./kg_diff [games [board_size win_length]]
+//   (default 20000 on 3x3)
+// on 3x3 it first walks every reachable game: both START pieces, every
+// player move through the text parser and every bot move, with game_bot
+// itself tried in all three bot modes at every bot turn (perfect and search
+// have to pick a move thats as good as a plain minimax says). after that,
+// or straight away on bigger boards, it plays random games out.
+// bad moves (taken cells, off the board, wrong turn, ...) get thrown at every
+// position too, they have to give the reference error and change nothing.
+// exits 1 on the first few mismatches, so its usable in CI
+#include <stdio.h>
+#include <stdlib.h>
+#include "kg_engine.h"
+
+#define MAX_REPORTS 10
+
+struct ref_game {
+    char cell[KG_MAX_BOARD][KG_MAX_BOARD]; // 'X', 'O' or 0
+    bool started;
+    bool over;
+    char piece;   // piece that moves next, the last one that moved once its over
+    char turn;    // 'P' or 'B'
+    char winner;  // '?', 'X', 'O' or 'D'
+    int moves;
+};
+
+static unsigned long positions, games, bot_checks, probes, mismatches;
+static int path[KG_MAX_BOARD * KG_MAX_BOARD]; // cells played so far, for reports
+static int depth;
+static int minimax_value[2 * 19683];          // 3^9 positions per side to move, 3x3 only
+static bool minimax_known[2 * 19683];
+
+static void report(const char *what, long got, long want) {
+    int i;
+
+    if (++mismatches > MAX_REPORTS)
+        return;
+    printf("MISMATCH %s: engine %ld reference %ld, after", what, got, want);
+    for (i = 0; i < depth; i++)
+        printf(" %d,%d", path[i] / kg_board_size + 1, path[i] % kg_board_size + 1);
+    printf("%s\n", depth ? "" : " nothing");
+}
+
+#define CHECK_EQ(what, got, want) do { \
+    long _g = (got), _w = (want); \
+    if (_g != _w) \
+        report(what, _g, _w); \
+} while (0)
+
+// field by field, game_state has padding a struct copy doesnt have to keep
+static bool same_game(const struct game_state *a, const struct game_state *b) {
+    if (a->lines && memcmp(a->lines, b->lines, sizeof(*a->lines)))
+        return false;
+    return a->current_piece == b->current_piece && a->current_player == b->current_player &&
+           a->game_started == b->game_started && a->game_over == b->game_over &&
+           a->winner == b->winner && a->pieces[0] == b->pieces[0] && a->pieces[1] == b->pieces[1] &&
+           a->num_moves == b->num_moves && a->moves == b->moves && a->start_ns == b->start_ns;
+}
+
+// reference rules
+
+static void ref_init(struct ref_game *ref) {
+    memset(ref, 0, sizeof(*ref));
+    ref->piece = '?';
+    ref->turn = '?';
+    ref->winner = '?';
+}
+
+// count the run through (row, col) one cell at a time
+static int ref_run(const struct ref_game *ref, int row, int col, int dr, int dc) {
+    int n = kg_board_size, len = 1, r, c;
+    char p = ref->cell[row][col];
+
+    for (r = row + dr, c = col + dc; r >= 0 && r < n && c >= 0 && c < n && ref->cell[r][c] == p; r += dr, c += dc)
+        len++;
+    for (r = row - dr, c = col - dc; r >= 0 && r < n && c >= 0 && c < n && ref->cell[r][c] == p; r -= dr, c -= dc)
+        len++;
+    return len;
+}
+
+// put the piece to move on (row, col) and settle the game. both sides go
+// through here, the turn after a move is the only difference
+static RETURN_CODES ref_move(struct ref_game *ref, int row, int col, char next_turn) {
+    int k = kg_win_length;
+
+    ref->cell[row][col] = ref->piece;
+    ref->moves++;
+    ref->turn = 'B'; // stays there when the game ends, whoever moved
+    if (ref_run(ref, row, col, 0, 1) >= k || ref_run(ref, row, col, 1, 0) >= k ||
+        ref_run(ref, row, col, 1, 1) >= k || ref_run(ref, row, col, 1, -1) >= k) {
+        ref->over = true;
+        ref->winner = ref->piece;
+        return GAME_OVER;
+    }
+    if (ref->moves == (int)(kg_board_size * kg_board_size)) {
+        ref->over = true;
+        ref->winner = 'D';
+        return GAME_OVER;
+    }
+    ref->turn = next_turn;
+    ref->piece = ref->piece == 'X' ? 'O' : 'X';
+    return OK;
+}
+
+static RETURN_CODES ref_play(struct ref_game *ref, int row, int col) {
+    int n = kg_board_size;
+
+    if (!ref->started)
+        return GAME_NOT_STARTED;
+    if (ref->over)
+        return GAME_OVER;
+    if (ref->turn != 'P')
+        return NOT_PLAYER_TURN;
+    if (row < 0 || row >= n || col < 0 || col >= n)
+        return OUT_OF_BOUNDS;
+    if (ref->cell[row][col])
+        return CANNOT_PLACE;
+    return ref_move(ref, row, col, 'B');
+}
+
+// what BOT gives back when its not allowed to move, OK if it is
+static RETURN_CODES ref_bot_allowed(const struct ref_game *ref) {
+    if (!ref->started)
+        return GAME_NOT_STARTED;
+    if (ref->turn != 'B')
+        return NOT_CPU_TURN;
+    if (ref->over)
+        return GAME_OVER;
+    return OK;
+}
+
+// every token w wide, one space between, a line per row
+static int ref_render(const struct ref_game *ref, char *buf) {
+    int n = kg_board_size, w = n > 9 ? 2 : 1, len = 0, r, c;
+
+    for (r = 0; r <= n; r++) {
+        for (c = 0; c <= n; c++) {
+            if (c)
+                buf[len++] = ' ';
+            if (!r && !c)
+                len += sprintf(buf + len, "%*s", w, ".");
+            else if (!r || !c)
+                len += sprintf(buf + len, "%*d", w, r ? r : c);
+            else
+                len += sprintf(buf + len, "%*c", w, ref->cell[r - 1][c - 1] ? ref->cell[r - 1][c - 1] : '_');
+        }
+        buf[len++] = '\n';
+    }
+    return len;
+}
+
+// 3x3 minimax for the side to move: 1 win, 0 draw, -1 loss
+static int ref_minimax(const struct ref_game *ref) {
+    // START O means the same cells can come up with either side to move
+    int index = piece_index(ref->piece), best = -2, r, c, v;
+
+    for (r = 0; r < 3; r++)
+        for (c = 0; c < 3; c++)
+            index = index * 3 + (ref->cell[r][c] == 'X' ? 1 : ref->cell[r][c] == 'O' ? 2 : 0);
+    if (minimax_known[index])
+        return minimax_value[index];
+    for (r = 0; r < 3; r++) {
+        for (c = 0; c < 3; c++) {
+            struct ref_game next = *ref;
+
+            if (ref->cell[r][c])
+                continue;
+            ref_move(&next, r, c, 'B');
+            v = next.over ? (next.winner == 'D' ? 0 : 1) : -ref_minimax(&next);
+            if (v > best)
+                best = v;
+        }
+    }
+    minimax_known[index] = true;
+    minimax_value[index] = best;
+    return best;
+}
+
+// comparing
+
+static void compare(const struct game_state *game, const struct ref_game *ref) {
+    char text[KG_BOARD_TEXT_MAX], ref_text[KG_BOARD_TEXT_MAX];
+    u16 rows[2][KG_MAX_BOARD];
+    struct game_state rebuilt;
+    struct kg_lines rebuilt_lines;
+    unsigned int n = kg_board_size;
+    int r, c, p, len, i;
+
+    positions++;
+    CHECK_EQ("game_started", game->game_started, ref->started);
+    CHECK_EQ("game_over", game->game_over, ref->over);
+    CHECK_EQ("winner", game->winner, ref->winner);
+    CHECK_EQ("num_moves", game->num_moves, ref->moves);
+    if (ref->started) {
+        CHECK_EQ("current_piece", game->current_piece, ref->piece);
+        CHECK_EQ("current_player", game->current_player, ref->turn);
+    }
+    for (p = 0; p < 2; p++) {
+        for (r = 0; r < (int)n; r++) {
+            u16 want = 0;
+
+            for (c = 0; c < (int)n; c++)
+                want |= (ref->cell[r][c] == "XO"[p]) << c;
+            rows[p][r] = board_row(game, p, r);
+            CHECK_EQ(p ? "O row" : "X row", rows[p][r], want);
+        }
+    }
+    // 3x3 keeps the move list for the history file
+    if (kg_classic()) {
+        for (i = 0; i < depth && i < game->num_moves; i++)
+            CHECK_EQ("move list", (game->moves >> (4 * i)) & 0xf, path[i]);
+    }
+
+    // the same board rebuilt from its rows, like a checkpoint restore does
+    game_init(&rebuilt, &rebuilt_lines);
+    game_set_rows(&rebuilt, rows[0], rows[1]);
+    if (kg_classic())
+        CHECK_EQ("board rebuilt from rows", rebuilt.pieces[0] == game->pieces[0] &&
+                 rebuilt.pieces[1] == game->pieces[1], 1);
+    else
+        CHECK_EQ("board rebuilt from rows", !memcmp(&rebuilt_lines, game->lines, sizeof(rebuilt_lines)), 1);
+
+    len = print_board_to_buffer(game, text, sizeof(text));
+    CHECK_EQ("board text length", len, ref_render(ref, ref_text));
+    CHECK_EQ("board text", !memcmp(text, ref_text, len), 1);
+    len = print_rows_to_buffer(rows[0], rows[1], text, sizeof(text));
+    CHECK_EQ("board text from rows", !memcmp(text, ref_text, len), 1);
+}
+
+// run a text command that doesnt move anything here, it has to fail the way the
+// reference says and leave the game alone
+static void probe(struct game_state *game, const char *line, RETURN_CODES want) {
+    struct game_state before;
+    struct kg_lines lines;
+    struct parsed_command cmd;
+
+    probes++;
+    game_copy(&before, &lines, game);
+    CHECK_EQ(line, process_command(game, line, &cmd), want);
+    CHECK_EQ("game changed by a failed command", same_game(game, &before), 1);
+}
+
+// every kind of command that cant move a piece, on a started game
+static void probe_all(struct game_state *game, const struct ref_game *ref) {
+    struct ref_game scratch = *ref;
+    char line[32];
+    int n = kg_board_size, r, c;
+
+    probe(game, "START X", GAME_STARTED);
+    probe(game, "PLAY 0 1", ref_play(&scratch, -1, 0));
+    scratch = *ref;
+    probe(game, "PLAY 1", ref_play(&scratch, -1, -1));
+    if (ref->started && ref_bot_allowed(ref) != OK)
+        probe(game, "BOT", ref_bot_allowed(ref));
+    probe(game, "BOT X", INVALID_BOT);
+    probe(game, "BOARD", OK);
+    probe(game, "BOARD whatever", OK);
+    probe(game, "PLAY 1 1 1", DEV_INVALID_COMMAND);
+    probe(game, "SIMULATE 0", DEV_INVALID_COMMAND);
+    probe(game, "SIMULATE 5", OK);
+    probe(game, "reset", DEV_INVALID_COMMAND);
+    // every taken cell, or every cell once its not the players turn
+    for (r = 0; r < n; r++) {
+        for (c = 0; c < n; c++) {
+            if (!ref->cell[r][c] && ref->started && !ref->over && ref->turn == 'P')
+                continue;
+            scratch = *ref;
+            snprintf(line, sizeof(line), "PLAY %d %d", r + 1, c + 1);
+            probe(game, line, ref_play(&scratch, r, c));
+        }
+    }
+}
+
+// a fresh game before START
+static void check_unstarted(void) {
+    struct game_state game;
+    struct kg_lines lines;
+    struct ref_game ref;
+
+    game_init(&game, &lines);
+    ref_init(&ref);
+    depth = 0;
+    compare(&game, &ref);
+    probe(&game, "PLAY 1 1", GAME_NOT_STARTED);
+    probe(&game, "BOT", GAME_NOT_STARTED);
+    probe(&game, "RESET", INVALID_RESET);
+    probe(&game, "START", MISSING_PIECE);
+    probe(&game, "START Y", INVALID_PIECE);
+    probe(&game, "START XO", kg_board_size > 9 ? INVALID_PIECE : DEV_INVALID_COMMAND);
+    probe(&game, "", DEV_INVALID_COMMAND);
+    probe(&game, "  \t", DEV_INVALID_COMMAND);
+    probe(&game, "PLAYX", DEV_INVALID_COMMAND);
+    compare(&game, &ref);
+}
+
+static void start(struct game_state *game, struct kg_lines *lines, struct ref_game *ref, char piece) {
+    struct parsed_command cmd;
+    char line[] = "START ?";
+
+    game_init(game, lines);
+    ref_init(ref);
+    line[6] = piece;
+    CHECK_EQ(line, process_command(game, line, &cmd), OK);
+    ref->started = true;
+    ref->piece = piece;
+    ref->turn = 'P';
+    depth = 0;
+}
+
+// RESET from anywhere after START is a fresh game again
+static void check_reset(const struct game_state *game) {
+    struct game_state copy, fresh;
+    struct kg_lines lines, fresh_lines;
+    struct parsed_command cmd;
+
+    game_copy(&copy, &lines, game);
+    CHECK_EQ("RESET", process_command(&copy, "RESET", &cmd), OK);
+    game_init(&fresh, &fresh_lines);
+    CHECK_EQ("game after RESET is new", same_game(&copy, &fresh), 1);
+}
+
+// player move through the text parser
+static RETURN_CODES play_text(struct game_state *game, struct ref_game *ref, int row, int col) {
+    struct parsed_command cmd;
+    char line[32];
+    RETURN_CODES want = ref_play(ref, row, col);
+
+    snprintf(line, sizeof(line), "PLAY %d %d", row + 1, col + 1);
+    CHECK_EQ(line, process_command(game, line, &cmd), want);
+    path[depth++] = row * kg_board_size + col;
+    return want;
+}
+
+// game_bot in one mode at this bot turn, and the move it makes has to be
+// legal and land like the reference says. returns the cell it picked
+static int check_bot(const struct game_state *game, const struct ref_game *ref, int mode) {
+    struct game_state copy;
+    struct kg_lines lines;
+    struct ref_game next = *ref;
+    int n = kg_board_size, p = piece_index(ref->piece), r, cell = -1, placed = 0;
+    RETURN_CODES got, want;
+
+    bot_checks++;
+    game_copy(&copy, &lines, game);
+    kg_bot_mode = mode;
+    got = game_bot(&copy);
+    for (r = 0; r < n; r++) {
+        u16 added = board_row(&copy, p, r) & ~board_row(game, p, r);
+
+        if (added) {
+            placed += hweight16(added);
+            cell = r * n + __ffs(added);
+        }
+    }
+    if (placed != 1 || ref->cell[cell / n][cell % n]) {
+        report("pieces the bot placed", placed, 1);
+        return -1;
+    }
+    want = ref_move(&next, cell / n, cell % n, 'P');
+    CHECK_EQ("BOT", got, want);
+    path[depth++] = cell;
+    compare(&copy, &next);
+    depth--;
+
+    // the table and the search have to be as good as a full minimax
+    if (kg_classic() && mode != KG_BOT_RANDOM) {
+        int best = ref_minimax(ref), v;
+
+        v = next.over ? (next.winner == 'D' ? 0 : 1) : -ref_minimax(&next);
+        CHECK_EQ(mode == KG_BOT_PERFECT ? "perfect bot move value" : "search bot move value", v, best);
+    }
+    return cell;
+}
+
+// every game from here, both sides trying every free cell
+static void walk(struct game_state *game, struct ref_game *ref) {
+    int r, c, mode;
+
+    compare(game, ref);
+    probe_all(game, ref);
+    if (ref->over) {
+        check_reset(game);
+        games++;
+        return;
+    }
+    if (ref->turn == 'B') {
+        for (mode = 0; mode < 3; mode++)
+            check_bot(game, ref, mode);
+    }
+    for (r = 0; r < 3; r++) {
+        for (c = 0; c < 3; c++) {
+            struct game_state next;
+            struct kg_lines lines;
+            struct ref_game next_ref = *ref;
+
+            if (ref->cell[r][c])
+                continue;
+            game_copy(&next, &lines, game);
+            if (ref->turn == 'P') {
+                play_text(&next, &next_ref, r, c);
+            } else {
+                // steer the bot onto this cell: game_play with the turn
+                // flipped places and settles the move the same way game_bot
+                // does, game_bot itself was checked above
+                next.current_player = 'P';
+                next_ref.turn = 'P';
+                CHECK_EQ("forced bot move", game_play(&next, r, c), ref_move(&next_ref, r, c, 'P'));
+                if (!next.game_over)
+                    next.current_player = 'P';
+                path[depth++] = r * 3 + c;
+            }
+            walk(&next, &next_ref);
+            depth--;
+        }
+    }
+}
+
+// random player moves against the real game_bot, to the end
+static void random_game(int i) {
+    struct game_state game;
+    struct kg_lines lines;
+    struct ref_game ref;
+    int n = kg_board_size, cell;
+
+    start(&game, &lines, &ref, (i & 1) ? 'O' : 'X');
+    while (!ref.over) {
+        compare(&game, &ref);
+        if (ref.turn == 'P') {
+            // a taken or off the board cell now and then
+            if (rand() % 8 == 0)
+                probe_all(&game, &ref);
+            do
+                cell = rand() % (n * n);
+            while (ref.cell[cell / n][cell % n]);
+            play_text(&game, &ref, cell / n, cell % n);
+        } else {
+            RETURN_CODES got;
+
+            if (check_bot(&game, &ref, i % 3) < 0)
+                return;
+            // check_bot ran on a copy, the real move here can be another
+            // cell (random bot), so read it back off the board
+            got = game_bot(&game);
+            for (cell = 0; cell < n * n; cell++) {
+                if (!ref.cell[cell / n][cell % n] &&
+                    ((board_row(&game, piece_index(ref.piece), cell / n) >> (cell % n)) & 1))
+                    break;
+            }
+            if (cell == n * n) {
+                report("bot moved", -1, 0);
+                return;
+            }
+            CHECK_EQ("BOT", got, ref_move(&ref, cell / n, cell % n, 'P'));
+            path[depth++] = cell;
+        }
+        if (mismatches > MAX_REPORTS)
+            return;
+    }
+    compare(&game, &ref);
+    probe_all(&game, &ref);
+    check_reset(&game);
+    games++;
+}
+
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 20000;
+    unsigned int size = argc > 3 ? atoi(argv[2]) : 3;
+    unsigned int win = argc > 3 ? atoi(argv[3]) : 3;
+    int i;
+
+    if (kg_engine_setup(size, win)) {
+        fprintf(stderr, "bad board %ux%u, %u in a row\n", size, size, win);
+        return 2;
+    }
+    printf("board %ux%u, %u in a row\n", size, size, win);
+    srand(1);
+    check_unstarted();
+
+    if (kg_classic()) {
+        struct game_state game;
+        struct kg_lines lines;
+        struct ref_game ref;
+
+        start(&game, &lines, &ref, 'X');
+        walk(&game, &ref);
+        start(&game, &lines, &ref, 'O');
+        walk(&game, &ref);
+        printf("every game: %lu games, %lu positions, %lu bot moves, %lu bad commands\n",
+               games, positions, bot_checks, probes);
+    }
+
+    games = positions = bot_checks = probes = 0;
+    for (i = 0; i < count && mismatches <= MAX_REPORTS; i++)
+        random_game(i);
+    printf("random games: %lu games, %lu positions, %lu bot moves, %lu bad commands\n",
+           games, positions, bot_checks, probes);
+
+    if (mismatches) {
+        printf("%lu mismatches\n", mismatches);
+        return 1;
+    }
+    printf("no mismatches\n");
+    return 0;
+}
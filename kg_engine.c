@@ -0,0 +1,901 @@
+// game engine, see kg_engine.h. built into the module and into
+// libkgengine.a for userspace (tests, kg_bench)
+#include "kg_engine.h"
+#include "kg_minimax_table.h" // generated by gen_minimax.c, see Makefile
+
+#ifdef __KERNEL__
+#include <linux/random.h>
+#include <linux/bitops.h>
+#include <linux/version.h>
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 2, 0)
+#define get_random_u32_below(ceil) prandom_u32_max(ceil)
+#endif
+#endif
+
+//double const feels silly but this makes both:
+//    pointer
+//    array
+// both consts, which is what i want!
+const char * const return_code_messages[] = {
+    "OK",
+    "MISSING_PIECE",
+    "INVALID_PIECE",
+    "GAME_STARTED",
+    "INVALID_RESET",
+    "GAME_NOT_STARTED",
+    "NOT_PLAYER_TURN",
+    "OUT_OF_BOUNDS",
+    "CANNOT_PLACE",
+    "GAME_OVER",
+    "INVALID_BOT",
+    "NOT_CPU_TURN",
+    "DEV_INVALID_COMMAND",
+    "SIM_RUNNING"
+};
+
+const char * const kg_cmd_names[KG_CMD_COUNT] = {
+    "START", "RESET", "PLAY", "BOT", "BOARD", "SIMULATE", "INVALID",
+};
+
+// every way to get 3 in a row, as cell masks
+static const u16 win_masks[8] = {
+    0x007, 0x038, 0x1c0, // rows
+    0x049, 0x092, 0x124, // columns
+    0x111, 0x054,        // diagonals
+};
+
+// the 8 lines above that go through each cell, bit i is win_masks[i]
+static const u8 lines_through[9] = {
+    0x49, 0x11, 0xa1,
+    0x0a, 0xd2, 0x22,
+    0x8c, 0x14, 0x64,
+};
+
+// what a fresh game looks like, copied in on open and on RESET
+const struct game_state new_game = {
+    .current_piece = '?',
+    .current_player = '?',
+    .game_started = false,
+    .game_over = false,
+    .winner = '?',
+    .pieces = { 0, 0 },
+    .num_moves = 0,
+    .moves = 0,
+    .start_ns = 0,
+    .lines = NULL
+};
+
+unsigned int kg_board_size = 3;
+unsigned int kg_win_length = 3;
+unsigned int kg_board_text_len = BOARD_TEXT_LEN;
+
+// N x N version of board_template/board_cell_offset below, built once by
+// kg_engine_setup so printing a big board is still a memcpy plus the pieces
+static char big_template[KG_BOARD_TEXT_MAX];
+static u16 big_cell_offset[KG_MAX_BOARD * KG_MAX_BOARD];
+
+// pick the board for every game from now on. call before any game exists
+int kg_engine_setup(unsigned int size, unsigned int win_length) {
+    unsigned int w, r, c, len = 0;
+
+    if (size < 3 || size > KG_MAX_BOARD || win_length < 3 || win_length > size)
+        return -EINVAL;
+    kg_board_size = size;
+    kg_win_length = win_length;
+    if (size == 3) {
+        kg_board_text_len = BOARD_TEXT_LEN;
+        return 0;
+    }
+
+    // same layout as the 3x3 board, every token padded to 2 wide past 9
+    w = size > 9 ? 2 : 1;
+    for (r = 0; r <= size; r++) {
+        for (c = 0; c <= size; c++) {
+            if (c)
+                big_template[len++] = ' ';
+            if (!r && !c)
+                len += snprintf(big_template + len, sizeof(big_template) - len, "%*s", w, ".");
+            else if (!r)
+                len += snprintf(big_template + len, sizeof(big_template) - len, "%*u", w, c);
+            else if (!c)
+                len += snprintf(big_template + len, sizeof(big_template) - len, "%*u", w, r);
+            else {
+                len += snprintf(big_template + len, sizeof(big_template) - len, "%*s", w, "_");
+                big_cell_offset[(r - 1) * size + c - 1] = len - 1;
+            }
+        }
+        big_template[len++] = '\n';
+    }
+    kg_board_text_len = len;
+    return 0;
+}
+
+void game_init(struct game_state *game, struct kg_lines *lines) {
+    *game = new_game;
+    if (!kg_classic()) {
+        memset(lines, 0, sizeof(*lines));
+        game->lines = lines;
+    }
+}
+
+void game_copy(struct game_state *to, struct kg_lines *lines, const struct game_state *from) {
+    *to = *from;
+    if (from->lines) {
+        *lines = *from->lines;
+        to->lines = lines;
+    }
+}
+
+DEFINE_PER_CPU(struct kg_stats, kg_stats);
+DEFINE_STATIC_KEY_FALSE(kg_debug_key);
+int kg_bot_mode = KG_BOT_RANDOM;
+
+// same pick on an N x N board, counted off a row at a time
+static int random_big_cell(const struct game_state *game) {
+    const struct kg_lines *l = game->lines;
+    unsigned int n = kg_board_size, r;
+    u16 row_mask = (1u << n) - 1;
+    u32 nth = get_random_u32_below(n * n - game->num_moves);
+
+    for (r = 0; r < n; r++) {
+        u16 free_cells = ~(l->rows[0][r] | l->rows[1][r]) & row_mask;
+        u32 count = hweight16(free_cells);
+
+        if (nth < count) {
+            while (nth--)
+                free_cells &= free_cells - 1;
+            return r * n + __ffs(free_cells);
+        }
+        nth -= count;
+    }
+    return -1; // cant happen, the board isnt full
+}
+
+// uniform pick among the free cells with one bounded rng call. used to
+// retry random cells until one was empty, which on a nearly full board
+// averaged 9 tries (18 rng calls). board is never full here, BOT refuses
+// finished games. cell is row * board size + col
+int random_bot_cell(const struct game_state *game) {
+    u16 free_cells;
+    u32 nth;
+
+    if (!kg_classic())
+        return random_big_cell(game);
+    free_cells = ~board_occupied(game) & FULL_BOARD;
+    nth = get_random_u32_below(hweight16(free_cells));
+
+    // drop the lowest free cell nth times, at most 8 steps
+    while (nth--)
+        free_cells &= free_cells - 1;
+    return __ffs(free_cells);
+}
+
+// one lookup in the table gen_minimax.c built at compile time
+int perfect_bot_cell(const struct game_state *game) {
+    int me = piece_index(game->current_piece);
+    u8 cell = kg_best_move[kg_ternary[game->pieces[me]] + 2 * kg_ternary[game->pieces[!me]]];
+
+    // only happens for a finished position, which BOT already refused
+    if (cell == KG_NO_MOVE)
+        return random_bot_cell(game);
+    return cell;
+}
+
+// transposition cache for the search bot, one table shared by every
+// session. positions are canonicalized over the 8 rotations/reflections
+// first, so a position and all its mirror images share one entry.
+//
+// an entry is a single u32, so lookups and stores are one plain load/store
+// on every arch and never tear. no lock: two cpus storing the same slot
+// just means one of two correct answers wins. entries are never removed,
+// the key check catches a slot thats been taken over by another position
+//   bit 31     valid
+//   bits 9-26  key, mine | theirs << 9 (canonical, side to move is mine)
+//   bits 4-8   score + 16
+//   bits 0-3   best cell, in the canonical orientation
+#define KG_TT_BITS 12
+#define KG_TT_SIZE (1 << KG_TT_BITS) // a 3x3 game has well under 1000 canonical positions
+#define KG_TT_PROBES 4
+#define KG_TT_VALID 0x80000000u
+
+static u32 kg_tt[KG_TT_SIZE];
+
+static inline u32 tt_slot(u32 key) {
+    return (key * 0x9e3779b1u) >> (32 - KG_TT_BITS);
+}
+
+// canonical key of the position and which symmetry gets there
+static u32 canonical_key(u16 mine, u16 theirs, int *sym) {
+    u32 best = ~0u, key;
+    int s;
+
+    for (s = 0; s < 8; s++) {
+        key = kg_sym[s][mine] | (u32)kg_sym[s][theirs] << 9;
+        if (key < best) {
+            best = key;
+            *sym = s;
+        }
+    }
+    return best;
+}
+
+static bool tt_lookup(u32 key, int *score, int *cell) {
+    unsigned int i, slot = tt_slot(key);
+    u32 entry;
+
+    this_cpu_inc(kg_stats.tt_lookups);
+    for (i = 0; i < KG_TT_PROBES; i++) {
+        entry = READ_ONCE(kg_tt[(slot + i) & (KG_TT_SIZE - 1)]);
+        if (!(entry & KG_TT_VALID))
+            return false;
+        if (((entry >> 9) & 0x3ffff) == key) {
+            *score = (int)((entry >> 4) & 0x1f) - 16;
+            *cell = entry & 0xf;
+            this_cpu_inc(kg_stats.tt_hits);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void tt_store(u32 key, int score, int cell) {
+    unsigned int i, slot = tt_slot(key);
+    u32 entry = KG_TT_VALID | key << 9 | (u32)(score + 16) << 4 | cell;
+    u32 *victim = &kg_tt[slot];
+
+    // first empty slot in the probe window, or the home slot if its full
+    for (i = 0; i < KG_TT_PROBES; i++) {
+        u32 *p = &kg_tt[(slot + i) & (KG_TT_SIZE - 1)];
+        if (!(READ_ONCE(*p) & KG_TT_VALID)) {
+            victim = p;
+            break;
+        }
+    }
+    WRITE_ONCE(*victim, entry);
+}
+
+static bool has_line(u16 mask) {
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(win_masks); i++) {
+        if ((mask & win_masks[i]) == win_masks[i])
+            return true;
+    }
+    return false;
+}
+
+// negamax from the side to move, scored like gen_minimax.c (a loss is
+// -(1 + empty cells), draw 0). *best_cell gets the move, -1 if the game is over
+static int search(u16 mine, u16 theirs, int *best_cell) {
+    u16 free_cells = ~(mine | theirs) & FULL_BOARD;
+    int sym, score, cell, best = -100;
+    u32 key;
+
+    *best_cell = -1;
+    if (has_line(theirs))
+        return -(1 + hweight16(free_cells));
+    if (!free_cells)
+        return 0;
+
+    key = canonical_key(mine, theirs, &sym);
+    if (tt_lookup(key, &best, &cell)) {
+        *best_cell = kg_sym_inv[sym][cell];
+        return best;
+    }
+    for (; free_cells; free_cells &= free_cells - 1) {
+        int c = __ffs(free_cells), reply;
+
+        score = -search(theirs, mine | (1u << c), &reply);
+        if (score > best) {
+            best = score;
+            *best_cell = c;
+        }
+    }
+    // cache it in the canonical orientation
+    tt_store(key, best, __ffs(kg_sym[sym][1u << *best_cell]));
+    return best;
+}
+
+// searched at move time, but every position any session has searched
+// before is one cache lookup
+int search_bot_cell(const struct game_state *game) {
+    int me = piece_index(game->current_piece);
+    int cell;
+
+    search(game->pieces[me], game->pieces[!me], &cell);
+    // only happens for a finished position, which BOT already refused
+    if (cell < 0)
+        return random_bot_cell(game);
+    return cell;
+}
+
+// board "printing", just fill it to buffer
+// format of: 4 x 4. 0,0 = '.', 0,# = #, #,0=#, so row/col nums printed on sides
+// inner 3 x 3 is board. spaces between each cell
+// each row will be 8 long, 7 + \n.
+// the shape never changes, so its a copy of this template with only the
+// played cells patched in (used to be ~20 snprintf calls per board)
+static const char board_template[] = ". 1 2 3\n1 _ _ _\n2 _ _ _\n3 _ _ _\n";
+// where cell (row * 3 + col) sits in board_template
+static const u8 board_cell_offset[9] = {
+    10, 12, 14,
+    18, 20, 22,
+    26, 28, 30,
+};
+
+static int print_big_board(const u16 *x_rows, const u16 *o_rows, char *buffer, size_t size) {
+    unsigned int n = kg_board_size, r;
+    u16 cells;
+
+    if (size < kg_board_text_len)
+        return 0;
+    memcpy(buffer, big_template, kg_board_text_len);
+    for (r = 0; r < n; r++) {
+        for (cells = x_rows[r]; cells; cells &= cells - 1)
+            buffer[big_cell_offset[r * n + __ffs(cells)]] = 'X';
+        for (cells = o_rows[r]; cells; cells &= cells - 1)
+            buffer[big_cell_offset[r * n + __ffs(cells)]] = 'O';
+    }
+    return kg_board_text_len;
+}
+
+static int print_classic_board(u16 x, u16 o, char *buffer, size_t size) {
+    u16 cells;
+
+    BUILD_BUG_ON(sizeof(board_template) - 1 != BOARD_TEXT_LEN);
+    if (size < BOARD_TEXT_LEN)
+        return 0;
+    memcpy(buffer, board_template, BOARD_TEXT_LEN);
+    // walk just the set bits, an early board is only a couple of stores
+    for (cells = x; cells; cells &= cells - 1)
+        buffer[board_cell_offset[__ffs(cells)]] = 'X';
+    for (cells = o; cells; cells &= cells - 1)
+        buffer[board_cell_offset[__ffs(cells)]] = 'O';
+    return BOARD_TEXT_LEN;
+}
+
+// returns how many chars went into buffer
+int print_board_to_buffer(const struct game_state *game, char *buffer, size_t size) {
+    if (!kg_classic())
+        return print_big_board(game->lines->rows[0], game->lines->rows[1], buffer, size);
+    return print_classic_board(game->pieces[0], game->pieces[1], buffer, size);
+}
+
+// same text from row masks (board_row layout) instead of a game, for
+// callers that only kept the rows
+int print_rows_to_buffer(const u16 *x_rows, const u16 *o_rows, char *buffer, size_t size) {
+    u16 x = 0, o = 0;
+    int r;
+
+    if (!kg_classic())
+        return print_big_board(x_rows, o_rows, buffer, size);
+    for (r = 0; r < 3; r++) {
+        x |= x_rows[r] << (3 * r);
+        o |= o_rows[r] << (3 * r);
+    }
+    return print_classic_board(x, o, buffer, size);
+}
+
+
+// helper for processing inputs 
+// already passed to kernel space so can safely just play w/ it
+
+
+// length of the run of set bits in line that goes through bit (which is set)
+static inline unsigned int run_through(u32 line, unsigned int bit) {
+    u32 gaps_below = ~line & ((1u << bit) - 1);
+
+    return __ffs(~(line >> bit)) + bit - fls(gaps_below);
+}
+
+// N x N: one word per direction, same cost on 4x4 and 16x16
+static int check_big_win(const struct game_state *game, int p, int row, int col) {
+    const struct kg_lines *l = game->lines;
+    unsigned int n = kg_board_size, k = kg_win_length;
+
+    if (run_through(l->rows[p][row], col) >= k ||
+        run_through(l->cols[p][col], row) >= k ||
+        run_through(l->diag[p][row - col + n - 1], col) >= k ||
+        run_through(l->anti[p][row + col], col) >= k)
+        return 1;
+    if (game->num_moves == n * n)
+        return 2;
+    return 0;
+}
+
+// check if a game has been won, piece just played (row, col). only lines
+// through that cell can have changed, so those are all that get looked at
+int check_win(const struct game_state *game, char piece, int row, int col) {
+    u16 mine = game->pieces[piece_index(piece)];
+    u8 lines;
+
+    if (!kg_classic())
+        return check_big_win(game, piece_index(piece), row, col);
+    // win first: a move that fills the last cell can still be a win
+    for (lines = lines_through[row * 3 + col]; lines; lines &= lines - 1) {
+        u16 w = win_masks[__ffs(lines)];
+        if ((mine & w) == w)
+            return 1;
+    }
+    // draw check: every cell taken and nobody won
+    if (board_occupied(game) == FULL_BOARD) {
+        return 2;
+    }
+    return 0;
+}
+
+static inline bool cell_taken(const struct game_state *game, int row, int col) {
+    if (kg_classic())
+        return board_occupied(game) & CELL_BIT(row, col);
+    return ((game->lines->rows[0][row] | game->lines->rows[1][row]) >> col) & 1;
+}
+
+// mark (row, col) as piece p's on the board, nothing else
+static inline void set_cell(struct game_state *game, int p, int row, int col) {
+    if (kg_classic()) {
+        game->pieces[p] |= CELL_BIT(row, col);
+    } else {
+        struct kg_lines *l = game->lines;
+
+        l->rows[p][row] |= 1u << col;
+        l->cols[p][col] |= 1u << row;
+        l->diag[p][row - col + kg_board_size - 1] |= 1u << col;
+        l->anti[p][row + col] |= 1u << col;
+    }
+}
+
+// put current_piece on (row, col), cell has to be free
+static void place_piece(struct game_state *game, int row, int col) {
+    set_cell(game, piece_index(game->current_piece), row, col);
+    if (kg_classic())
+        game->moves |= (u64)(row * 3 + col) << (4 * game->num_moves);
+    game->num_moves++;
+}
+
+// fill a fresh game's board from row masks (board_row layout), for a
+// restored checkpoint. rows have to fit the board and not overlap, every
+// other field is the callers, num_moves included
+void game_set_rows(struct game_state *game, const u16 *x_rows, const u16 *o_rows) {
+    unsigned int r;
+    u16 cells;
+
+    for (r = 0; r < kg_board_size; r++) {
+        for (cells = x_rows[r]; cells; cells &= cells - 1)
+            set_cell(game, 0, r, __ffs(cells));
+        for (cells = o_rows[r]; cells; cells &= cells - 1)
+            set_cell(game, 1, r, __ffs(cells));
+    }
+}
+// the game_* functions below are the actual rules, they take already
+// decoded arguments so both the text commands (validate_*) and the ioctls
+// share them. validate_* only deal with what the text parser produced.
+
+// START
+// piece is 'X' or 'O', '\0' if it wasnt given
+RETURN_CODES game_start(struct game_state *game, char piece) {
+    // if game started, return GAME_STARTED
+    if (game->game_started) {
+        printk_test("[FAIL] GAME ALREADY STARTED\n");
+        return GAME_STARTED;
+    }
+    // MISSING_PIECE -> if 0 args
+    if (piece == '\0') {
+        printk_test("[FAIL] MISSING_PIECE\n");
+        return MISSING_PIECE;
+    }
+    // INVALID PIECE -> if arg not X or O
+    if (piece != 'X' && piece != 'O') {
+        printk_test("[FAIL] INVALID PIECE\n");
+        return INVALID_PIECE;
+    }
+    // otherwise, initialize game and set player piece to
+    game->current_piece = piece;
+    game->current_player = 'P';
+    game->game_started = true;
+    game->start_ns = ktime_get_ns();
+    kg_dbg("Game started with player piece: %c\n", game->current_piece);
+    printk_test("[PASS] GAME STARTED\n");
+
+    return OK;
+}
+
+// validate args first because error depends on them!
+// MISSING_PIECE
+// function arg is passed parsed_command, so 
+static RETURN_CODES validate_start_command(struct game_state *game, const struct parsed_command *cmd){
+    // command = 1, only START passed -> no piece
+    if (cmd->num_tokens == 1)
+        return game_start(game, '\0');
+    // "XO" can get past the parser on a big board, its still not a piece
+    return game_start(game, cmd->arg_len[0] == 1 ? cmd->args[0] : '?');
+}
+
+// RESET
+RETURN_CODES game_reset(struct game_state *game) {
+    if (game->game_started == false) {
+        printk_test("[FAIL] INVALID RESET, GAME NOT STARTED\n");
+        return INVALID_RESET;
+    }
+    // its a valid reset, so clear game state + board back to a fresh game
+    game_init(game, game->lines);
+    kg_dbg("Game reset successfully\n");
+    printk_test("[PASS] GAME RESET\n");
+    return OK;
+}
+
+static RETURN_CODES validate_reset_command(struct game_state *game, const struct parsed_command *cmd){
+    // if any args, invalid!
+    if (cmd->num_tokens > 1) { // command = 1, so if more than that, invalid
+        printk_test("[FAIL] INVALID RESET ARGUMENTS\n");
+        return INVALID_RESET;
+    }
+    return game_reset(game);
+}
+
+
+// PLAY
+// row and col are 0 based, anything off the board (like -1 for a missing
+// argument) is OUT_OF_BOUNDS
+RETURN_CODES game_play(struct game_state *game, int row, int col) {
+    int winStatus;
+
+    // GAME_NOT_STARTED if not started
+    if (game->game_started == false) {
+        printk_test("[FAIL] GAME NOT STARTED\n");
+        return GAME_NOT_STARTED;
+    }
+    // if game over, return GAME_OVER
+    if (game->game_over) {
+        printk_test("[FAIL] GAME OVER\n");
+        return GAME_OVER;
+    }
+
+    // must be your turn to play
+    if (game->current_player != 'P') {
+        printk_test("[FAIL] NOT PLAYER TURN\n");
+        return NOT_PLAYER_TURN;
+    }
+
+    // validate row and col are on the board
+    if (row < 0 || row >= (int)kg_board_size || col < 0 || col >= (int)kg_board_size) {
+        printk_test("[FAIL] OUT OF BOUNDS\n");
+        return OUT_OF_BOUNDS;
+    }
+    
+
+
+    // if cell occupied, return CANNOT_PLACE
+    if (cell_taken(game, row, col)) {
+        printk_test("[FAIL] CANNOT PLACE\n");
+        return CANNOT_PLACE;
+    }
+
+
+    // otherwise, place piece and update game state
+    place_piece(game, row, col);
+    // switch turn to bot
+    game->current_player = 'B';
+    kg_dbg("Player placed %c at (%d, %d)\n", game->current_piece, row + 1, col + 1);
+    trace_kg_move_applied(game->current_piece, row + 1, col + 1, false);
+    printk_test("[PASS] PLAYER MOVE ACCEPTED\n");
+    // check if player won
+    winStatus = check_win(game, game->current_piece, row, col);
+    if (winStatus == 1) {
+        game->game_over = true;
+        game->winner = game->current_piece;
+        kg_dbg("Player %c wins!\n", game->current_piece);
+        trace_kg_game_over(game->winner);
+        this_cpu_inc(kg_stats.games_won);
+        kg_history_record(game, game->current_piece);
+        printk_test("[PASS] PLAYER WINS\n");
+        return GAME_OVER;
+    }
+    else if (winStatus == 2) {
+        game->game_over = true;
+        game->winner = 'D';
+        kg_dbg("Game is a draw!\n");
+        printk_test("[PASS] GAME DRAW\n");
+        trace_kg_game_over(game->winner);
+        this_cpu_inc(kg_stats.games_drawn);
+        kg_history_record(game, game->current_piece);
+        return GAME_OVER;
+    }
+    // game isnt over!
+    game->current_player = 'B';
+    kg_dbg("Switched turn to: %c\n", game->current_player);
+
+    game->current_piece = (game->current_piece == 'X') ? 'O' : 'X';
+
+    return OK;
+}
+
+static RETURN_CODES validate_play_command(struct game_state *game, const struct parsed_command *cmd){
+    // if missing args, return OUT_OF_BOUNDS
+    if (cmd->num_tokens < 3) { // command + 2 args = 3
+        return game_play(game, -1, -1);
+    }
+    // 1 based, non numbers are -1 so they land out of bounds too
+    return game_play(game, cmd->values[0] - 1, cmd->values[1] - 1);
+}
+
+
+
+
+// BOT
+static int bot_cell(const struct game_state *game, int mode) {
+    // the table and the search only know 3x3, bigger boards are always random
+    switch (kg_classic() ? mode : KG_BOT_RANDOM) {
+    case KG_BOT_PERFECT:
+        return perfect_bot_cell(game);
+    case KG_BOT_SEARCH:
+        return search_bot_cell(game);
+    default:
+        return random_bot_cell(game);
+    }
+}
+
+RETURN_CODES game_bot(struct game_state *game) {
+    u64 start;
+    int cell, row, col, winStatus;
+
+    // game not started
+    if (game->game_started == false) {
+        printk_test("[FAIL] GAME NOT STARTED\n");
+        return GAME_NOT_STARTED;
+    }
+    // not bots turn
+    if (game->current_player != 'B') {
+        printk_test("[FAIL] NOT BOT TURN\n");
+        return NOT_CPU_TURN;
+    }
+    //game is over
+    if (game->game_over) {
+        printk_test("[FAIL] GAME OVER\n");
+        return GAME_OVER;
+    }
+    // make a move:
+    start = ktime_get_ns();
+    cell = bot_cell(game, READ_ONCE(kg_bot_mode));
+    row = cell / kg_board_size;
+    col = cell % kg_board_size;
+    place_piece(game, row, col);
+    // counted here so the moves that end the game are in it too
+    this_cpu_inc(kg_stats.bot_lat[lat_bucket(start)]);
+    kg_dbg("Bot placed %c at (%d, %d)\n", game->current_piece, row + 1, col + 1);
+    trace_kg_move_applied(game->current_piece, row + 1, col + 1, true);
+    printk_test("[PASS] BOT MOVE ACCEPTED\n");
+    // check if bot won
+    winStatus = check_win(game, game->current_piece, row, col);
+    if (winStatus == 1) {
+        game->game_over = true;
+        game->winner = game->current_piece;
+        kg_dbg("Bot %c wins!\n", game->current_piece);
+        trace_kg_game_over(game->winner);
+        this_cpu_inc(kg_stats.games_lost);
+        kg_history_record(game, game->current_piece == 'X' ? 'O' : 'X');
+        printk_test("[PASS] BOT WINS\n");
+        return GAME_OVER;
+    }
+    if (winStatus == 2) {
+        game->game_over = true;
+        game->winner = 'D';
+        kg_dbg("Game is a draw!\n");
+        printk_test("[PASS] GAME DRAW\n");
+        trace_kg_game_over(game->winner);
+        this_cpu_inc(kg_stats.games_drawn);
+        kg_history_record(game, game->current_piece == 'X' ? 'O' : 'X');
+        return GAME_OVER;
+    }
+    // game isnt over, swap back
+    game->current_player = 'P';
+    game->current_piece = (game->current_piece == 'X') ? 'O' : 'X';
+    return OK;
+
+}
+
+// bot against bot on a private board, for SIMULATE. no game_bot, so none
+// of the player stats, latency or history see these games
+char kg_self_play(int bot_mode) {
+    struct game_state game;
+    struct kg_lines lines;
+    int cell, row, col;
+
+    game_init(&game, &lines);
+    game.game_started = true;
+    game.current_player = 'B';
+    game.current_piece = 'X';
+    for (;;) {
+        cell = bot_cell(&game, bot_mode);
+        row = cell / kg_board_size;
+        col = cell % kg_board_size;
+        place_piece(&game, row, col);
+        switch (check_win(&game, game.current_piece, row, col)) {
+        case 1:
+            return game.current_piece;
+        case 2:
+            return 'D';
+        }
+        game.current_piece = (game.current_piece == 'X') ? 'O' : 'X';
+    }
+}
+
+static RETURN_CODES validate_bot_command(struct game_state *game, const struct parsed_command *cmd){
+    // no arguments
+    if (cmd->num_tokens > 1) { // command = 1, so if more than that, invalid
+        printk_test("[FAIL] INVALID BOT ARGUMENTS\n");
+        return INVALID_BOT;
+    }
+    return game_bot(game);
+}
+
+// SIMULATE <games>
+static RETURN_CODES validate_simulate_command(struct game_state *game, const struct parsed_command *cmd) {
+    // the games dont touch this game, the driver just needs a sane count
+    if (cmd->num_tokens != 2 || cmd->values[0] < 1 || cmd->values[0] > KG_SIM_MAX_GAMES) {
+        printk_test("[FAIL] INVALID GAME COUNT\n");
+        return DEV_INVALID_COMMAND;
+    }
+    printk_test("[PASS] SIMULATE ACCEPTED\n");
+    return OK;
+}
+
+// BOARD
+static RETURN_CODES validate_board_command(struct game_state *game, const struct parsed_command *cmd){
+    // no validation just let it run
+    // otherwise, just print the board to buffer and return OK
+    // the driver sees KG_CMD_BOARD and puts the board in the reply
+    printk_test("[PASS] BOARD PRINTED\n");
+    return OK;
+}
+
+
+// every text command, the parser matches the first word against name and
+// calls handler straight from here. arg_count is informational, handlers
+// decide what missing/extra args mean since that changes the error code
+#define KG_CMD(cmd_name, args, fn) { .name = cmd_name, .name_len = sizeof(cmd_name) - 1, .arg_count = args, .handler = fn }
+static const struct {
+    const char *name;
+    int name_len;
+    int arg_count;
+    RETURN_CODES (*handler)(struct game_state *game, const struct parsed_command *cmd);
+} valid_commands[] = {
+    KG_CMD("START", 1, validate_start_command),  //takes in 'X' or 'O'
+    KG_CMD("RESET", 0, validate_reset_command),
+    KG_CMD("PLAY",  2, validate_play_command),
+    KG_CMD("BOT",   0, validate_bot_command),
+    KG_CMD("BOARD", 0, validate_board_command), // any args are ignored
+    KG_CMD("SIMULATE", 1, validate_simulate_command), // game count, up to 9 digits
+};
+
+static inline bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// "1" to "16" style args, -1 if its not all digits
+static int parse_number(const char *word, int len) {
+    int value = 0, i;
+
+    for (i = 0; i < len; i++) {
+        if (word[i] < '0' || word[i] > '9')
+            return -1;
+        value = value * 10 + word[i] - '0';
+    }
+    return value;
+}
+
+// one pass over the line, no copies and no shared state (used to be a
+// strtok with a static cursor plus a strncmp chain run twice).
+// fills cmd and returns the index into valid_commands, or -1 if the line
+// can never be a valid command
+int parse_command(const char *line, struct parsed_command *cmd) {
+    const char *p = line;
+    const char *word;
+    int len, i, index = -1, max_len;
+
+    cmd->type = KG_CMD_INVALID;
+    cmd->num_tokens = 0;
+    cmd->args[0] = '\0';
+    cmd->args[1] = '\0';
+    cmd->values[0] = -1;
+    cmd->values[1] = -1;
+
+    // first token: should be the command
+    while (is_separator(*p))
+        p++;
+    word = p;
+    while (*p && !is_separator(*p))
+        p++;
+    len = p - word;
+
+    if (len == 0) {
+        kg_dbg("empty\n");
+        trace_kg_parse_error("empty");
+        printk_test("[FAIL] EMPTY COMMAND\n");
+        return -1;
+    }
+    for (i = 0; i < ARRAY_SIZE(valid_commands); i++) {
+        if (valid_commands[i].name_len == len && memcmp(word, valid_commands[i].name, len) == 0) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        kg_dbg("Invalid command: %.*s\n", len, word);
+        trace_kg_parse_error(len > 8 ? "command too long" : "unknown command");
+        printk_test("[FAIL] INVALID COMMAND\n");
+        return -1;
+    }
+    cmd->num_tokens = 1; // we caught the initial command
+    // SIMULATEs count is the one arg thats allowed to be long
+    max_len = valid_commands[index].handler == validate_simulate_command ? 9 :
+              kg_board_size > 9 ? 2 : 1;
+
+    // BOARD dont care about any args
+    if (valid_commands[index].handler == validate_board_command) {
+        cmd->type = index;
+        return index;
+    }
+
+    // args: only will be 'X' 'O', or a row/col number. so longer than 1 is invalid
+    // (2 once the board goes past 9, 9 for SIMULATE), and a 3rd arg will always be invalid
+    for (;;) {
+        while (is_separator(*p))
+            p++;
+        if (!*p)
+            break;
+        word = p;
+        while (*p && !is_separator(*p))
+            p++;
+        if (cmd->num_tokens > 2) {
+            kg_dbg("Too many arguments, extra token: %.*s\n", (int)(p - word), word);
+            trace_kg_parse_error("too many arguments");
+            printk_test("[FAIL] TOO MANY ARGUMENTS\n");
+            return -1;
+        }
+        if (p - word > max_len) {
+            kg_dbg("Argument %d too long: %.*s\n", cmd->num_tokens, (int)(p - word), word);
+            trace_kg_parse_error("argument too long");
+            printk_test("[FAIL] TOO LONG\n");
+            return -1;
+        }
+        cmd->args[cmd->num_tokens - 1] = *word;
+        cmd->arg_len[cmd->num_tokens - 1] = p - word;
+        cmd->values[cmd->num_tokens - 1] = parse_number(word, p - word);
+        cmd->num_tokens++;
+    }
+    // only now, a line with bad args stays KG_CMD_INVALID
+    cmd->type = index;
+    return index;
+}
+
+// run one text command against game. cmd gets the parsed line, cmd->type
+// says which command it was (KG_CMD_INVALID if it didnt parse)
+RETURN_CODES process_command(struct game_state *game, const char *command, struct parsed_command *cmd) {
+    int index = parse_command(command, cmd);
+
+    BUILD_BUG_ON(ARRAY_SIZE(valid_commands) != KG_CMD_INVALID);
+    if (index < 0)
+        return DEV_INVALID_COMMAND;
+
+    kg_dbg("Command: %s, Argument 1: %c, Argument 2: %c\n", valid_commands[index].name,
+           cmd->args[0] ? cmd->args[0] : '-', cmd->args[1] ? cmd->args[1] : '-');
+    // handlers decide what a wrong arg count means, this is just for the log
+    if (cmd->num_tokens - 1 != valid_commands[index].arg_count &&
+        valid_commands[index].handler != validate_board_command) {
+        printk_test("[FAIL] INVALID ARGUMENT COUNT\n");
+    }
+    printk_test("[PASS] VALID COMMAND AND ARG COUNT\n");
+
+    // print the gamestate for debugging
+    if (kg_debug_enabled()) {
+        printk(KERN_INFO "Current game state:\n");
+        printk(KERN_INFO "Current piece: %c\n", game->current_piece);
+        printk(KERN_INFO "Current player: %c\n", game->current_player);
+        printk(KERN_INFO "Game started: %d\n", game->game_started);
+        printk(KERN_INFO "Game over: %d\n", game->game_over);
+        printk(KERN_INFO "Winner: %c\n", game->winner);
+    }
+
+    return valid_commands[index].handler(game, cmd);
+}
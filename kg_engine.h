@@ -0,0 +1,222 @@
+// the game itself: rules, bots, parser and board rendering.
+// no files, locks or user copies in here, kg_main.c is the driver around it.
+// builds two ways:
+//  - in the module (kbuild, __KERNEL__), with tracepoints, per cpu stats and
+//    the debug static key
+//  - as a plain userspace library (make libkgengine.a), kg_user_compat.h
+//    stands in for the kernel bits so the engine can be tested/benchmarked
+//    without insmod
+#ifndef KG_ENGINE_H
+#define KG_ENGINE_H
+
+#ifdef __KERNEL__
+#include <linux/kernel.h>
+#include <linux/types.h>
+#include <linux/string.h>
+#include <linux/percpu.h>
+#include <linux/ktime.h>
+#include <linux/jump_label.h>
+#include <linux/log2.h>
+#include "kernelgame_trace.h"
+#else
+#include "kg_user_compat.h"
+#endif
+
+//how should i store error / return codes?
+/* error codes and messages */
+typedef enum {
+    OK = 0,
+    MISSING_PIECE,
+    INVALID_PIECE,
+    GAME_STARTED,
+    INVALID_RESET,
+    GAME_NOT_STARTED,
+    NOT_PLAYER_TURN,
+    OUT_OF_BOUNDS,
+    CANNOT_PLACE,
+    GAME_OVER,
+    INVALID_BOT,
+    NOT_CPU_TURN,
+    DEV_INVALID_COMMAND,
+    SIM_RUNNING,        // SIMULATE while this file already has one going
+    KG_RESULT_COUNT
+} RETURN_CODES;
+extern const char * const return_code_messages[];
+
+// what the parser hands to a command handler
+struct parsed_command {
+    int type;        // KG_CMD_*, KG_CMD_INVALID if the line didnt parse
+    int num_tokens;  // command word + args, so 1 = no args
+    char args[2];    // first char of each arg ('X', '1', ...), '\0' when missing
+    u8 arg_len[2];   // 1, or 2 for a two digit row/col on boards over 9
+    int values[2];   // args as numbers for PLAY/SIMULATE, -1 if not a number
+};
+
+// board geometry, fixed at load (board_size/win_length module parameters)
+// by kg_engine_setup. 3x3 is the classic game and has its own fast path on
+// the 9-bit bitboards in game_state.pieces, everything bigger plays on
+// struct kg_lines
+#define KG_MAX_BOARD 16
+extern unsigned int kg_board_size;  // N, board is N x N
+extern unsigned int kg_win_length;  // K in a row wins
+extern unsigned int kg_board_text_len; // what print_board_to_buffer writes
+int kg_engine_setup(unsigned int size, unsigned int win_length);
+
+static inline bool kg_classic(void) {
+    return kg_board_size == 3;
+}
+
+// rotated bitboards for N x N, [0] is X and [1] is O. every line the board
+// has (row, column, both diagonals) is one u16 with consecutive bits for
+// consecutive cells, so "how long is the run through this cell" is a couple
+// of bit ops per direction, no matter how big the board is
+struct kg_lines {
+    u16 rows[2][KG_MAX_BOARD];          // rows[p][r] bit c
+    u16 cols[2][KG_MAX_BOARD];          // cols[p][c] bit r
+    u16 diag[2][2 * KG_MAX_BOARD - 1];  // diag[p][r - c + N - 1] bit c
+    u16 anti[2][2 * KG_MAX_BOARD - 1];  // anti[p][r + c] bit c
+};
+// game state, (which turn it is (PIECE), which turn it is (PLAYER/BOT), if game has started, if game has ended, who won)
+// use struct and also move board into it
+struct game_state {
+    char current_piece;   // X or O, ? default !!! THIS IS THE PLAYER PIECE, bot is the opposite then
+    char current_player;  // P or B, ? default
+    bool game_started;
+    bool game_over;
+    char winner;          // 'X', 'O', or 'D', inits to ?
+    // bitboards, bit (row * 3 + col) is set where that piece has played.
+    // [0] is X, [1] is O (see piece_index)
+    u16 pieces[2];
+    u16 num_moves;        // moves played so far
+    u64 moves;            // 3x3 only: move i was cell (row * 3 + col) in bits 4i..4i+3
+    u64 start_ns;         // when START was played, for the history record
+    struct kg_lines *lines; // N x N only (NULL on 3x3), the board lives here
+};
+
+#define CELL_BIT(row, col) (1u << ((row) * 3 + (col)))
+#define FULL_BOARD 0x1ff // all 9 cells
+
+static inline int piece_index(char piece) {
+    return piece == 'O';
+}
+
+static inline u16 board_occupied(const struct game_state *game) {
+    return game->pieces[0] | game->pieces[1];
+}
+
+// what a fresh game looks like, copied in on open and on RESET
+extern const struct game_state new_game;
+
+// fresh game, lines is the board storage for N x N (ignored on 3x3)
+void game_init(struct game_state *game, struct kg_lines *lines);
+// copy of from in to, with its N x N board copied into lines (to->lines
+// points there after). a plain struct copy would share from's board
+void game_copy(struct game_state *to, struct kg_lines *lines, const struct game_state *from);
+void game_set_rows(struct game_state *game, const u16 *x_rows, const u16 *o_rows);
+
+// row r of piece p (0 = X) as a bitmask, bit c set where its played
+static inline u16 board_row(const struct game_state *game, int p, int r) {
+    if (kg_classic())
+        return (game->pieces[p] >> (3 * r)) & 0x7;
+    return game->lines->rows[p][r];
+}
+
+// command types, same order as the parser table. process_command reports
+// which one a line was, the driver uses it for BOARD replies, SIMULATE and
+// stats
+enum {
+    KG_CMD_START, KG_CMD_RESET, KG_CMD_PLAY, KG_CMD_BOT, KG_CMD_BOARD,
+    KG_CMD_SIMULATE, // engine only checks the count, the driver runs the games
+    KG_CMD_INVALID, // line that didnt parse
+    KG_CMD_COUNT
+};
+extern const char * const kg_cmd_names[KG_CMD_COUNT];
+
+// which bot answers BOT, read on every BOT so it can be changed while loaded
+// (the module exposes it as the bot_mode parameter)
+enum {
+    KG_BOT_RANDOM = 0,  // any free cell
+    KG_BOT_PERFECT = 1, // precomputed minimax table, never loses
+    KG_BOT_SEARCH = 2,  // negamax at move time through the shared transposition cache
+};
+extern int kg_bot_mode;
+
+// stats, read with cat /sys/kernel/debug/wtictactoe/stats
+// per cpu so counting never bounces a cacheline between cpus, summed on read
+#define KG_LAT_BUCKETS 32 // log2(ns), last bucket is everything >= 2^31 ns
+
+struct kg_stats {
+    u64 commands[KG_CMD_COUNT];
+    u64 results[KG_RESULT_COUNT];  // by RETURN_CODES
+    u64 games_won;     // player won
+    u64 games_lost;    // bot won
+    u64 games_drawn;
+    u64 write_lat[KG_LAT_BUCKETS];  // whole kg_write call
+    u64 bot_lat[KG_LAT_BUCKETS];    // picking + applying a bot move
+    u64 tt_lookups;    // search bot transposition cache
+    u64 tt_hits;
+    u64 sim_games;     // bot vs bot games played for SIMULATE
+};
+DECLARE_PER_CPU(struct kg_stats, kg_stats);
+
+static inline unsigned int lat_bucket(u64 start_ns) {
+    u64 ns = ktime_get_ns() - start_ns;
+    return ns ? min_t(unsigned int, ilog2(ns), KG_LAT_BUCKETS - 1) : 0;
+}
+
+// debug logging is off by default, a single "PLAY 1 1" used to be ~30 printks
+// and the ring buffer was the throughput ceiling. its a static key (flipped by
+// the debug module parameter), so while its off every kg_dbg/printk_test is
+// just a nop in the instruction stream, not even a load+branch
+DECLARE_STATIC_KEY_FALSE(kg_debug_key);
+#define kg_debug_enabled() static_branch_unlikely(&kg_debug_key)
+
+#define kg_dbg(format, ...) do { \
+    if (kg_debug_enabled()) \
+        printk(KERN_INFO format, ##__VA_ARGS__); \
+} while (0)
+
+//debug printk wrapper that adds prefix of [TESTAID]
+// 2nd arg is a pass/fail with [PASS][FAIL]
+
+#define TESTAID_PREFIX "[TESTAID] "
+#define printk_test(format, ...) kg_dbg(TESTAID_PREFIX format, ##__VA_ARGS__)
+
+// a game just ended, hand it to the history ring (kg_history.c). player is
+// the piece START picked. userspace builds have no ring
+#ifdef __KERNEL__
+void kg_history_record(const struct game_state *game, char player);
+#else
+static inline void kg_history_record(const struct game_state *game, char player) { }
+#endif
+
+// 3x3 board text is always this long, see print_board_to_buffer
+#define BOARD_TEXT_LEN 32
+// biggest board text: N + 1 lines of N + 1 two char tokens, spaces and a newline
+#define KG_BOARD_TEXT_MAX ((KG_MAX_BOARD + 1) * (3 * KG_MAX_BOARD + 3))
+
+int check_win(const struct game_state *game, char piece, int row, int col);
+int print_board_to_buffer(const struct game_state *game, char *buffer, size_t size);
+int print_rows_to_buffer(const u16 *x_rows, const u16 *o_rows, char *buffer, size_t size);
+int random_bot_cell(const struct game_state *game);
+int perfect_bot_cell(const struct game_state *game);
+int search_bot_cell(const struct game_state *game);
+
+// the rules, with already decoded arguments. shared by the text commands
+// and the ioctls
+RETURN_CODES game_start(struct game_state *game, char piece);
+RETURN_CODES game_reset(struct game_state *game);
+RETURN_CODES game_play(struct game_state *game, int row, int col);
+RETURN_CODES game_bot(struct game_state *game);
+
+// SIMULATE N: 1 to KG_SIM_MAX_GAMES games. kg_self_play plays one of them,
+// bot_mode on both sides, X first. touches no stats or history, returns
+// the winner ('X', 'O' or 'D')
+#define KG_SIM_MAX_GAMES 100000000
+char kg_self_play(int bot_mode);
+
+// text commands
+int parse_command(const char *line, struct parsed_command *cmd);
+RETURN_CODES process_command(struct game_state *game, const char *command, struct parsed_command *cmd);
+
+#endif
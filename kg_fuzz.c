@@ -0,0 +1,151 @@
+// fuzz target for the text command path: parse_command, the validators and
+// the rules behind them, on any board. built two ways:
+//  - make kg_fuzz: libFuzzer (clang -fsanitize=fuzzer,address,undefined)
+//  - make kg_fuzz_replay: same checks with a main() that runs files (or
+//    stdin) through them, for AFL or for replaying a crash with gcc
+//
+// input: byte 0 picks the board size, byte 1 the win length (low nibble)
+// and bot mode (high nibble), the rest is command lines like the driver
+// hands them over (too long ones it answers itself, so theyre skipped).
+// after every line the game has
+// to still make sense, a command that failed cant have changed it and the
+// board text has to be the same both ways its rendered. any of that going
+// wrong aborts, so the fuzzer saves the input
+#include <stdio.h>
+#include <stdlib.h>
+#include "kg_engine.h"
+
+#define LINE_MAX_LEN 127 // BUFF_SIZE in kg_main.c, minus the '\0'
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "kg_fuzz: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        abort(); \
+    } \
+} while (0)
+
+static void check_game(const struct game_state *game) {
+    char text[KG_BOARD_TEXT_MAX], rows_text[KG_BOARD_TEXT_MAX];
+    u16 rows[2][KG_MAX_BOARD];
+    unsigned int n = kg_board_size, r, x = 0, o = 0;
+
+    for (r = 0; r < n; r++) {
+        rows[0][r] = board_row(game, 0, r);
+        rows[1][r] = board_row(game, 1, r);
+        CHECK(!(rows[0][r] & rows[1][r]));
+        CHECK(!((rows[0][r] | rows[1][r]) >> n));
+        x += hweight16(rows[0][r]);
+        o += hweight16(rows[1][r]);
+    }
+    CHECK(x + o == game->num_moves);
+    CHECK(x <= o + 1 && o <= x + 1);
+    if (!game->game_started) {
+        CHECK(game->num_moves == 0 && !game->game_over);
+    } else {
+        CHECK(game->current_piece == 'X' || game->current_piece == 'O');
+        CHECK(game->current_player == 'P' || game->current_player == 'B');
+    }
+    if (game->game_over)
+        CHECK(game->winner == 'X' || game->winner == 'O' || game->winner == 'D');
+    else
+        CHECK(game->winner == '?' && game->num_moves < n * n);
+
+    CHECK(print_board_to_buffer(game, text, sizeof(text)) == (int)kg_board_text_len);
+    CHECK(print_rows_to_buffer(rows[0], rows[1], rows_text, sizeof(rows_text)) == (int)kg_board_text_len);
+    CHECK(!memcmp(text, rows_text, kg_board_text_len));
+}
+
+static void run_line(struct game_state *game, const char *line) {
+    struct game_state before = *game;
+    struct kg_lines before_lines;
+    struct parsed_command cmd;
+    RETURN_CODES result;
+
+    if (game->lines)
+        before_lines = *game->lines;
+    result = process_command(game, line, &cmd);
+
+    CHECK(result >= OK && result < KG_RESULT_COUNT);
+    CHECK(cmd.type >= 0 && cmd.type <= KG_CMD_INVALID);
+    CHECK((cmd.type == KG_CMD_INVALID) == (parse_command(line, &cmd) < 0));
+    if (cmd.type == KG_CMD_INVALID)
+        CHECK(result == DEV_INVALID_COMMAND);
+    // only a move adds a piece, only RESET takes them away
+    if (cmd.type == KG_CMD_RESET && result == OK)
+        CHECK(game->num_moves == 0 && !game->game_started);
+    else if (game->num_moves != before.num_moves)
+        CHECK(game->num_moves == before.num_moves + 1 &&
+              (cmd.type == KG_CMD_PLAY || cmd.type == KG_CMD_BOT) && (result == OK || result == GAME_OVER));
+    // anything else that failed left the game alone
+    if (result != OK && game->num_moves == before.num_moves) {
+        CHECK(game->game_started == before.game_started && game->game_over == before.game_over);
+        CHECK(game->current_piece == before.current_piece && game->current_player == before.current_player);
+        CHECK(!game->lines || !memcmp(game->lines, &before_lines, sizeof(before_lines)));
+        CHECK(game->pieces[0] == before.pieces[0] && game->pieces[1] == before.pieces[1]);
+    }
+    check_game(game);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    struct game_state game;
+    struct kg_lines lines;
+    char line[LINE_MAX_LEN + 1];
+    unsigned int n, k;
+    size_t i, len = 0;
+    bool too_long = false;
+
+    if (size < 2)
+        return 0;
+    n = 3 + data[0] % (KG_MAX_BOARD - 2);
+    k = 3 + (data[1] & 0xf) % (n - 2);
+    CHECK(kg_engine_setup(n, k) == 0);
+    kg_bot_mode = (data[1] >> 4) % 3;
+    game_init(&game, &lines);
+
+    // split like kg_write_batch. a '\0' inside a line ends the string
+    // there, same as in the driver
+    for (i = 2; i <= size; i++) {
+        if (i == size || data[i] == '\n') {
+            line[len] = '\0';
+            if (len && !too_long)
+                run_line(&game, line);
+            len = 0;
+            too_long = false;
+        } else if (len < LINE_MAX_LEN) {
+            line[len++] = data[i];
+        } else {
+            too_long = true;
+        }
+    }
+    return 0;
+}
+
+#ifdef KG_FUZZ_MAIN
+static void run_file(FILE *f, const char *name) {
+    static uint8_t buf[1 << 16];
+    size_t size = fread(buf, 1, sizeof(buf), f);
+
+    LLVMFuzzerTestOneInput(buf, size);
+    printf("%s: ok\n", name);
+}
+
+int main(int argc, char **argv) {
+    int i;
+
+    if (argc < 2) {
+        run_file(stdin, "stdin");
+        return 0;
+    }
+    for (i = 1; i < argc; i++) {
+        FILE *f = fopen(argv[i], "rb");
+
+        if (!f) {
+            perror(argv[i]);
+            return 1;
+        }
+        run_file(f, argv[i]);
+        fclose(f);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,183 @@
+// finished game history, so games dont just vanish on RESET.
+//
+// every cpu has its own ring of compact records. the cpu that finishes a
+// game is the only writer of its ring (preemption is off while it writes),
+// so recording is a few stores and a release, no locks and no shared
+// cachelines. the ring is drained by reading
+//   /sys/kernel/debug/wtictactoe/history
+// which hands out every record not read yet, one line per game, and frees
+// the slots. readers are serialized by a mutex, that never touches the
+// move path. if nobody drains, a full ring drops new games and counts them
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/smp.h>
+#include <linux/uaccess.h>
+#include "kg_engine.h"
+#include "kg_history.h"
+
+// 32 bytes per game
+struct kg_game_record {
+    u64 end_ns;        // wall clock (ktime_get_real_ns) when it finished
+    u64 moves;         // same packing as game_state.moves, 0 past 3x3
+    u64 duration_us;   // START to the last move. a game can sit idle for days, u32 wraps after 71 minutes
+    u16 num_moves;
+    char player;       // piece the player picked
+    char winner;       // 'X', 'O', 'D'
+};
+
+struct kg_history_ring {
+    u32 head;          // next slot to write, only the owning cpu moves it
+    u32 tail;          // next slot to read, only a reader moves it
+    u64 dropped;       // games lost because the ring was full
+    struct kg_game_record *records;
+};
+
+static DEFINE_PER_CPU(struct kg_history_ring, kg_history);
+static DEFINE_MUTEX(kg_history_read_lock);
+
+static unsigned int history_size = 4096;
+module_param(history_size, uint, 0444);
+MODULE_PARM_DESC(history_size, "finished games kept per cpu until read, rounded up to a power of 2, 0 turns history off (default 4096)");
+
+void kg_history_record(const struct game_state *game, char player) {
+    struct kg_history_ring *ring = get_cpu_ptr(&kg_history);
+    struct kg_game_record *rec;
+    u32 head = ring->head;
+
+    if (!ring->records)
+        goto out;
+    // tail only ever moves forward, a stale one just looks fuller
+    if (head - smp_load_acquire(&ring->tail) >= history_size) {
+        ring->dropped++;
+        goto out;
+    }
+    rec = &ring->records[head & (history_size - 1)];
+    rec->end_ns = ktime_get_real_ns();
+    rec->moves = game->moves;
+    rec->duration_us = div_u64(ktime_get_ns() - game->start_ns, NSEC_PER_USEC);
+    rec->num_moves = game->num_moves;
+    rec->player = player;
+    rec->winner = game->winner;
+    // record is complete before the reader can see it
+    smp_store_release(&ring->head, head + 1);
+out:
+    put_cpu_ptr(&kg_history);
+}
+
+u64 kg_history_dropped(void) {
+    u64 dropped = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+        dropped += READ_ONCE(per_cpu_ptr(&kg_history, cpu)->dropped);
+    return dropped;
+}
+
+// "<end ns> <duration us> <player> <winner> <moves>\n", moves are 1 based
+// "rowcol" like PLAY takes them, in play order: 1699999999000000000 812 X O 22,11,33,13
+// boards past 3x3 dont keep the move list, they get the move count instead:
+// 1699999999000000000 9120 X O #41
+#define KG_HISTORY_LINE_MAX 96
+
+static int format_record(const struct kg_game_record *rec, char *line, size_t size) {
+    int len, i;
+
+    len = scnprintf(line, size, "%llu %llu %c %c ", rec->end_ns, rec->duration_us,
+                    rec->player, rec->winner);
+    if (!kg_classic())
+        return len + scnprintf(line + len, size - len, "#%u\n", rec->num_moves);
+    for (i = 0; i < rec->num_moves; i++) {
+        unsigned int cell = (rec->moves >> (4 * i)) & 0xf;
+
+        len += scnprintf(line + len, size - len, "%s%u%u", i ? "," : "",
+                         cell / 3 + 1, cell % 3 + 1);
+    }
+    len += scnprintf(line + len, size - len, "\n");
+    return len;
+}
+
+// drains: whatever is handed out is gone from the rings. returns 0 (EOF)
+// once everything recorded so far has been read, so cat finishes
+static ssize_t kg_history_read(struct file *filp, char __user *buf, size_t count, loff_t *ppos)
+{
+    char line[KG_HISTORY_LINE_MAX];
+    ssize_t done = 0;
+    int cpu, len;
+
+    if (mutex_lock_interruptible(&kg_history_read_lock))
+        return -ERESTARTSYS;
+    for_each_possible_cpu(cpu) {
+        struct kg_history_ring *ring = per_cpu_ptr(&kg_history, cpu);
+        u32 head;
+
+        if (!ring->records)
+            continue;
+        head = smp_load_acquire(&ring->head);
+        while (ring->tail != head) {
+            len = format_record(&ring->records[ring->tail & (history_size - 1)],
+                                line, sizeof(line));
+            if (len > count - done) {
+                // not even one line fits, dont pretend theres nothing left
+                if (!done)
+                    done = -EINVAL;
+                goto out;
+            }
+            if (copy_to_user(buf + done, line, len)) {
+                if (!done)
+                    done = -EFAULT;
+                goto out;
+            }
+            done += len;
+            // slot is free for the producer again
+            smp_store_release(&ring->tail, ring->tail + 1);
+        }
+    }
+out:
+    mutex_unlock(&kg_history_read_lock);
+    return done;
+}
+
+const struct file_operations kg_history_fops = {
+    .owner = THIS_MODULE,
+    .open = nonseekable_open,
+    .read = kg_history_read,
+};
+
+int kg_history_init(void) {
+    int cpu;
+
+    if (!history_size)
+        return 0;
+    if (history_size > (1u << 24)) {
+        printk(KERN_ERR "history_size is at most %u\n", 1u << 24);
+        return -EINVAL;
+    }
+    history_size = roundup_pow_of_two(history_size);
+    for_each_possible_cpu(cpu) {
+        struct kg_history_ring *ring = per_cpu_ptr(&kg_history, cpu);
+
+        ring->records = kvcalloc(history_size, sizeof(*ring->records), GFP_KERNEL);
+        if (!ring->records) {
+            kg_history_exit();
+            return -ENOMEM;
+        }
+    }
+    return 0;
+}
+
+void kg_history_exit(void) {
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        struct kg_history_ring *ring = per_cpu_ptr(&kg_history, cpu);
+
+        kvfree(ring->records);
+        ring->records = NULL;
+    }
+}
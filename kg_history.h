@@ -0,0 +1,15 @@
+// finished game ring buffers, see kg_history.c. kg_history_record itself
+// is declared in kg_engine.h since the engine is what calls it
+#ifndef KG_HISTORY_H
+#define KG_HISTORY_H
+
+#include <linux/fs.h>
+#include <linux/types.h>
+
+extern const struct file_operations kg_history_fops; // the debugfs "history" file
+
+int kg_history_init(void);
+void kg_history_exit(void);
+u64 kg_history_dropped(void);
+
+#endif
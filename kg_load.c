@@ -0,0 +1,426 @@
+// load generator for /dev/wtictactoe, needs the module loaded.
+// opens N fds spread over M threads, every thread plays full games on its
+// fds round robin as fast as it can, then reports games/sec and per command
+// latency percentiles. give it a list of thread counts to see how it scales.
+//
+// usage: ./kg_load [-d dev] [-t threads,...] [-n fds] [-s seconds] [-m mode]
+//   -d  device node (default /dev/wtictactoe)
+//   -t  thread counts to run, one run each (default 1,2,4,8)
+//   -n  fds per run, split over the threads (default 4 per thread, keep it
+//       under games_per_device or opens fail with EBUSY)
+//   -s  seconds per run (default 2)
+//   -m  text  = write/read commands, BOARD to see the bot's move (default)
+//       ioctl = KG_IOC_* ioctls, the state comes back with every call
+//       mmap  = text commands, board read from the mmap'd kg_shared_state
+// only plays the 3x3 board, so the module has to be loaded with board_size=3
+// (the default)
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+#include "kernelgame_ioctl.h"
+
+enum { MODE_TEXT, MODE_IOCTL, MODE_MMAP };
+static const char * const mode_names[] = { "text", "ioctl", "mmap" };
+
+enum { CMD_START, CMD_PLAY, CMD_BOT, CMD_BOARD, CMD_RESET, CMD_COUNT };
+static const char * const cmd_names[CMD_COUNT] = { "START", "PLAY", "BOT", "BOARD", "RESET" };
+
+// log-linear latency histogram: exact below 16 ns, then 16 buckets per
+// power of two (~6% resolution), covers anything a u64 of ns can hold
+#define SUB_BITS 4
+#define SUB_BUCKETS (1 << SUB_BITS)
+#define HIST_BUCKETS (64 * SUB_BUCKETS)
+
+struct hist {
+    unsigned long long count;
+    unsigned long long bucket[HIST_BUCKETS];
+};
+
+static unsigned int hist_index(unsigned long long ns) {
+    int e;
+
+    if (ns < SUB_BUCKETS)
+        return ns;
+    e = 63 - __builtin_clzll(ns);
+    return (e - SUB_BITS + 1) * SUB_BUCKETS + ((ns >> (e - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+// smallest ns that lands in bucket idx
+static unsigned long long hist_value(unsigned int idx) {
+    unsigned int e = idx / SUB_BUCKETS + SUB_BITS - 1;
+
+    if (idx < SUB_BUCKETS)
+        return idx;
+    return (1ULL << e) | ((unsigned long long)(idx % SUB_BUCKETS) << (e - SUB_BITS));
+}
+
+static unsigned long long hist_percentile(const struct hist *h, double pct) {
+    unsigned long long want = (unsigned long long)(h->count * pct / 100.0);
+    unsigned long long seen = 0;
+    unsigned int i;
+
+    if (!h->count)
+        return 0;
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->bucket[i];
+        if (seen > want)
+            return hist_value(i);
+    }
+    return hist_value(HIST_BUCKETS - 1);
+}
+
+struct client {
+    int fd;
+    struct kg_shared_state *shared; // mmap mode only
+};
+
+struct worker {
+    pthread_t thread;
+    struct client *clients;
+    int num_clients;
+    unsigned int rng;
+    unsigned long long games;
+    unsigned long long errors;
+    struct hist lat[CMD_COUNT];
+};
+
+static const char *dev_path = "/dev/wtictactoe";
+static int mode = MODE_TEXT;
+static volatile int stop;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static unsigned int next_rand(unsigned int *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+// what a game looks like to the client after a command
+struct view {
+    int code;              // enum kg_result
+    unsigned int occupied; // cells taken, bit row * 3 + col
+};
+
+// text protocol, one write then one read per command. the reply always
+// fits in one read, and it was the only one queued so the EOF never has
+// to be read
+static int text_command(struct client *c, const char *line, char *reply, size_t size) {
+    size_t len = strlen(line);
+    ssize_t n;
+
+    if (write(c->fd, line, len) != (ssize_t)len)
+        return -1;
+    n = read(c->fd, reply, size - 1);
+    if (n <= 0)
+        return -1;
+    reply[n] = '\0';
+    return 0;
+}
+
+static int code_from_reply(const char *reply) {
+    static const char * const names[] = {
+        "OK", "MISSING_PIECE", "INVALID_PIECE", "GAME_STARTED", "INVALID_RESET",
+        "GAME_NOT_STARTED", "NOT_PLAYER_TURN", "OUT_OF_BOUNDS", "CANNOT_PLACE",
+        "GAME_OVER", "INVALID_BOT", "NOT_CPU_TURN", "DEV_INVALID_COMMAND", "SIM_RUNNING",
+    };
+    size_t len = strcspn(reply, "\n");
+    unsigned int i;
+
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strlen(names[i]) == len && !strncmp(reply, names[i], len))
+            return i;
+    }
+    return -1;
+}
+
+// cells of the BOARD reply, same layout as board_template in kg_engine.c
+static unsigned int occupied_from_board(const char *board) {
+    static const unsigned char offset[9] = { 10, 12, 14, 18, 20, 22, 26, 28, 30 };
+    unsigned int mask = 0;
+    int i;
+
+    for (i = 0; i < 9; i++) {
+        if (board[offset[i]] == 'X' || board[offset[i]] == 'O')
+            mask |= 1u << i;
+    }
+    return mask;
+}
+
+static unsigned int occupied_from_mmap(const struct kg_shared_state *sh) {
+    unsigned int seq;
+    struct kg_ioc_state snap;
+
+    do {
+        seq = __atomic_load_n(&sh->seq, __ATOMIC_ACQUIRE);
+        snap = sh->state;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&sh->seq, __ATOMIC_RELAXED));
+    return snap.x_mask | snap.o_mask;
+}
+
+static const unsigned long ioc_for_cmd[CMD_COUNT] = {
+    [CMD_START] = KG_IOC_START,
+    [CMD_PLAY] = KG_IOC_PLAY,
+    [CMD_BOT] = KG_IOC_BOT,
+    [CMD_BOARD] = KG_IOC_GET_BOARD,
+    [CMD_RESET] = KG_IOC_RESET,
+};
+
+// run one command, time it, and fill in what the client now knows
+static int run(struct worker *w, struct client *c, int cmd, int cell, struct view *v) {
+    char line[32], reply[256];
+    unsigned long long start = now_ns();
+    int ret = 0;
+
+    if (mode == MODE_IOCTL) {
+        struct kg_ioc_cmd req = { .piece = 'X', .row = cell / 3 + 1, .col = cell % 3 + 1 };
+
+        ret = ioctl(c->fd, ioc_for_cmd[cmd], &req);
+        if (!ret) {
+            v->code = req.code;
+            v->occupied = req.state.x_mask | req.state.o_mask;
+        }
+    } else {
+        switch (cmd) {
+        case CMD_START: strcpy(line, "START X\n"); break;
+        case CMD_PLAY:  snprintf(line, sizeof(line), "PLAY %d %d\n", cell / 3 + 1, cell % 3 + 1); break;
+        case CMD_BOT:   strcpy(line, "BOT\n"); break;
+        case CMD_BOARD: strcpy(line, "BOARD\n"); break;
+        default:        strcpy(line, "RESET\n"); break;
+        }
+        ret = text_command(c, line, reply, sizeof(reply));
+        if (!ret) {
+            if (cmd == CMD_BOARD) {
+                v->code = KG_OK;
+                v->occupied = occupied_from_board(reply);
+            } else {
+                v->code = code_from_reply(reply);
+            }
+        }
+    }
+
+    unsigned long long ns = now_ns() - start;
+    struct hist *h = &w->lat[cmd];
+    h->bucket[hist_index(ns)]++;
+    h->count++;
+    return ret;
+}
+
+// START, then PLAY/BOT until someone wins or it's a draw, then RESET
+static int play_game(struct worker *w, struct client *c) {
+    struct view v = { 0, 0 };
+    int cell, free_cells, nth;
+
+    if (run(w, c, CMD_START, 0, &v) || v.code != KG_OK)
+        goto fail;
+    for (;;) {
+        // random free cell, so games dont all go the same way
+        free_cells = 9 - __builtin_popcount(v.occupied);
+        nth = next_rand(&w->rng) % free_cells;
+        for (cell = 0; cell < 9; cell++) {
+            if (!(v.occupied & (1u << cell)) && nth-- == 0)
+                break;
+        }
+        if (run(w, c, CMD_PLAY, cell, &v))
+            goto fail;
+        if (v.code == KG_GAME_OVER)
+            break;
+        if (v.code != KG_OK)
+            goto fail;
+        if (run(w, c, CMD_BOT, 0, &v))
+            goto fail;
+        if (v.code == KG_GAME_OVER)
+            break;
+        if (v.code != KG_OK)
+            goto fail;
+        // ioctl replies already carry the board
+        if (mode == MODE_TEXT) {
+            if (run(w, c, CMD_BOARD, 0, &v))
+                goto fail;
+        } else if (mode == MODE_MMAP) {
+            v.occupied = occupied_from_mmap(c->shared);
+        }
+    }
+    if (run(w, c, CMD_RESET, 0, &v) || v.code != KG_OK)
+        goto fail;
+    return 0;
+fail:
+    // get the game back to a known state for the next round
+    run(w, c, CMD_RESET, 0, &v);
+    return -1;
+}
+
+static void *worker_main(void *arg) {
+    struct worker *w = arg;
+    int i = 0;
+
+    while (!stop) {
+        if (play_game(w, &w->clients[i]))
+            w->errors++;
+        else
+            w->games++;
+        if (++i == w->num_clients)
+            i = 0;
+    }
+    return NULL;
+}
+
+static int open_client(struct client *c) {
+    c->shared = NULL;
+    c->fd = open(dev_path, O_RDWR);
+    if (c->fd < 0) {
+        fprintf(stderr, "open %s: %s%s\n", dev_path, strerror(errno),
+                errno == EBUSY ? " (more fds than games_per_device?)" : "");
+        return -1;
+    }
+    if (mode == MODE_MMAP) {
+        c->shared = mmap(NULL, 4096, PROT_READ, MAP_SHARED, c->fd, 0);
+        if (c->shared == MAP_FAILED) {
+            fprintf(stderr, "mmap %s: %s\n", dev_path, strerror(errno));
+            close(c->fd);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void close_client(struct client *c) {
+    if (c->shared)
+        munmap(c->shared, 4096);
+    close(c->fd);
+}
+
+// one run at a fixed thread count, returns games/sec or -1
+static double run_load(int threads, int fds, int seconds) {
+    struct worker *workers = calloc(threads, sizeof(*workers));
+    struct client *clients = calloc(fds, sizeof(*clients));
+    struct hist *total = calloc(CMD_COUNT, sizeof(*total));
+    unsigned long long games = 0, errors = 0, start, elapsed;
+    int i, j, opened = 0, per, cmd;
+    double rate = -1;
+
+    if (!workers || !clients || !total) {
+        fprintf(stderr, "out of memory\n");
+        goto out;
+    }
+    for (opened = 0; opened < fds; opened++) {
+        if (open_client(&clients[opened]))
+            goto out;
+    }
+
+    // fds split as evenly as they go, the first few threads get one extra
+    for (i = 0, j = 0; i < threads; i++) {
+        per = fds / threads + (i < fds % threads);
+        workers[i].clients = &clients[j];
+        workers[i].num_clients = per;
+        workers[i].rng = 2463534242u + i * 7919;
+        j += per;
+    }
+
+    stop = 0;
+    start = now_ns();
+    for (i = 0; i < threads; i++)
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    sleep(seconds);
+    stop = 1;
+    for (i = 0; i < threads; i++)
+        pthread_join(workers[i].thread, NULL);
+    elapsed = now_ns() - start;
+
+    for (i = 0; i < threads; i++) {
+        games += workers[i].games;
+        errors += workers[i].errors;
+        for (cmd = 0; cmd < CMD_COUNT; cmd++) {
+            total[cmd].count += workers[i].lat[cmd].count;
+            for (j = 0; j < HIST_BUCKETS; j++)
+                total[cmd].bucket[j] += workers[i].lat[cmd].bucket[j];
+        }
+    }
+    rate = games / (elapsed / 1e9);
+
+    printf("\nthreads %d, fds %d, mode %s: %llu games in %.2f s = %.0f games/s, %llu errors\n",
+           threads, fds, mode_names[mode], games, elapsed / 1e9, rate, errors);
+    printf("  %-6s %12s %10s %10s %10s\n", "cmd", "count", "p50 ns", "p99 ns", "p999 ns");
+    for (cmd = 0; cmd < CMD_COUNT; cmd++) {
+        if (!total[cmd].count)
+            continue;
+        printf("  %-6s %12llu %10llu %10llu %10llu\n", cmd_names[cmd], total[cmd].count,
+               hist_percentile(&total[cmd], 50), hist_percentile(&total[cmd], 99),
+               hist_percentile(&total[cmd], 99.9));
+    }
+
+out:
+    for (i = 0; i < opened; i++)
+        close_client(&clients[i]);
+    free(workers);
+    free(clients);
+    free(total);
+    return rate;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-d dev] [-t threads,...] [-n fds] [-s seconds] [-m text|ioctl|mmap]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    char thread_list[256] = "1,2,4,8";
+    int fds = 0, seconds = 2;
+    int counts[64], num_counts = 0;
+    double rates[64];
+    char *tok;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "d:t:n:s:m:")) != -1) {
+        switch (opt) {
+        case 'd': dev_path = optarg; break;
+        case 't': snprintf(thread_list, sizeof(thread_list), "%s", optarg); break;
+        case 'n': fds = atoi(optarg); break;
+        case 's': seconds = atoi(optarg); break;
+        case 'm':
+            for (mode = 0; mode < 3 && strcmp(optarg, mode_names[mode]); mode++)
+                ;
+            if (mode == 3)
+                usage(argv[0]);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (seconds < 1)
+        usage(argv[0]);
+
+    for (tok = strtok(thread_list, ","); tok && num_counts < 64; tok = strtok(NULL, ",")) {
+        counts[num_counts] = atoi(tok);
+        if (counts[num_counts] < 1)
+            usage(argv[0]);
+        num_counts++;
+    }
+
+    for (i = 0; i < num_counts; i++) {
+        int n = fds ? fds : counts[i] * 4;
+        // every thread needs at least one fd
+        rates[i] = run_load(counts[i], n < counts[i] ? counts[i] : n, seconds);
+        if (rates[i] < 0)
+            return 1;
+    }
+
+    printf("\nscaling (%s):\n  %7s %12s %8s\n", mode_names[mode], "threads", "games/s", "speedup");
+    for (i = 0; i < num_counts; i++)
+        printf("  %7d %12.0f %7.2fx\n", counts[i], rates[i], rates[0] > 0 ? rates[i] / rates[0] : 0);
+    return 0;
+}
@@ -0,0 +1,1180 @@
+#include <linux/module.h> // Needed for all kernel modules
+#include <linux/kernel.h> // Needed for KERN_INFO
+#include <linux/init.h>   // Needed for macros like __init and __exit
+#include <linux/fs.h>
+#include <linux/cdev.h>
+#include <linux/device.h>
+#include <asm/segment.h>
+#include <asm/uaccess.h>
+#include <linux/buffer_head.h>
+#include <linux/moduleparam.h>
+#include <linux/string.h> 
+#include <linux/slab.h>
+#include <linux/mutex.h>
+#include <linux/wait.h>
+#include <linux/poll.h>
+#include <linux/mm.h>
+#include <linux/spinlock.h>
+#include <linux/bitmap.h>
+#include <linux/percpu.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/seqlock.h>
+#include <linux/random.h>
+#include <linux/jump_label.h>
+#include <linux/version.h>
+
+#include "kernelgame_ioctl.h"
+#include "kg_engine.h" // rules, bots, parser, board. shared with the userspace build
+#include "kg_history.h"
+#include "kg_sim.h"
+#include "kg_checkpoint.h"
+// last, kg_engine.h already pulled the header in for the declarations. this
+// is the one place the tracepoints get defined
+#define CREATE_TRACE_POINTS
+#include "kernelgame_trace.h"
+
+#define DEVICE_NAME "wtictactoe"
+
+static int major;
+
+//class
+static struct class* kg_class;
+
+
+// static char device_buffer[BUFFER_SIZE]; // static = no malloc needed
+#define BUFF_SIZE 128 // longest command line
+#define REPLY_QUEUE_LEN 64 // replies a file can have waiting, power of 2
+#define REPLY_LINE_MAX 64 // room one reply line (or a 3x3 board) can need
+#define REPLY_TEXT_MAX (REPLY_LINE_MAX + KG_BOARD_TEXT_MAX) // longest rendered reply
+
+// one reply waiting to be read. kept as what happened, not as text, and
+// rendered by whoever reads it (see render_reply)
+enum { KG_REPLY_CODE, KG_REPLY_BOARD, KG_REPLY_SIM };
+
+struct kg_reply {
+    u32 seq;          // command line on this file it answers, from 1
+    u8 kind;          // KG_REPLY_*
+    u8 code;          // RETURN_CODES, for KG_REPLY_CODE
+    bool with_seq;    // reply_seq as of the push, so a reply always renders the same
+    union {
+        struct {
+            u16 x_rows[KG_MAX_BOARD];
+            u16 o_rows[KG_MAX_BOARD];
+        } board;                  // KG_REPLY_BOARD, right after the BOARD ran
+        struct kg_sim_result sim; // KG_REPLY_SIM
+    };
+};
+
+// one of these per open file, hung off filp->private_data
+// so every opener plays their own game instead of sharing one
+//
+// concurrency:
+//  - there is no global lock, different sessions never touch shared state,
+//    so separate opens run fully in parallel on different cpus
+//  - lock protects everything below it. writers (kg_write) hold it for the
+//    whole parse + apply + reply update of one command, so two threads
+//    writing the same fd get their commands applied one after the other
+//  - every command line queues one reply in replies, kg_read drains them in
+//    order, rendering into read_buf under the lock. copy_to_user happens
+//    after unlocking so a slow or faulting reader never blocks the move
+//    path. read_lock keeps read_buf to one reader through that copy. a full
+//    queue holds writers back until a reader makes room
+//  - board readers (GET_BOARD ioctls) dont take it at all, they copy
+//    published under published_seq, which the writer refreshes after every
+//    command. a BOT thats still thinking never holds them up
+//  - user copies (copy_from_user in write, copy_to_user in read) are always
+//    done outside the lock
+//  - wait is woken after every command (text or ioctl), blocking readers and
+//    poll/epoll sleep on it instead of sleep-and-cat loops
+struct kg_session {
+    struct mutex lock;
+    struct mutex read_lock;  // read_buf, taken before lock when both are
+    wait_queue_head_t wait;
+    struct game_state game;
+    struct kg_lines lines;   // game.lines points here on boards past 3x3
+    // game as of the last finished command, for readers that dont take
+    // lock (see snapshot_game). only written by publish_state
+    seqcount_mutex_t published_seq;
+    struct game_state published;
+    struct kg_lines published_lines;
+    struct kg_reply replies[REPLY_QUEUE_LEN]; // FIFO, filled by write, drained by read
+    u32 reply_head;          // next slot to fill, free running
+    u32 reply_tail;          // oldest unread reply
+    u32 reply_off;           // how much of the tail reply has been read already
+    u32 next_seq;            // seq the next command line gets
+    bool reply_seq;          // put "<seq> " in front of replies queued from now on (KG_IOC_REPLY_SEQ)
+    bool eof_sent;           // replies all read and the 0 (EOF) handed out, next read blocks
+    char read_buf[REPLY_TEXT_MAX]; // kg_read renders here, a 16x16 board is too big for the stack
+    struct kg_shared_state *shared; // page handed out by mmap, NULL until first mmap
+    struct kg_node *node;    // device node whose table this slot is in
+    unsigned int slot;       // index in node->slots
+    u64 game_id;             // KG_IOC_GAME_ID, random per open or the resumed games
+    struct kg_sim *sim;      // last SIMULATE, NULL if there wasnt one
+    bool sim_running;        // cleared by kg_sim_done once the result is in
+    bool sim_text;           // started by a write, so the result goes in the reply
+    u32 sim_seq;             // seq of that SIMULATE line
+};
+
+// sessions come from their own slab cache, all allocated up front at load
+// (games_per_device per node) and only given back at unload. START/RESET
+// and open/close never touch the allocator. cacheline aligned so two games
+// being played on different cpus never share a line
+static struct kmem_cache *kg_session_cache;
+
+// one per /dev node (minor). each has its own fixed table of game slots, so
+// tenants on different nodes cant eat each others capacity, and an open
+// never allocates, it just claims a free slot
+struct kg_node {
+    spinlock_t lock;            // protects used
+    unsigned long *used;        // bit per slot, set while a file has it open
+    struct kg_session **slots;  // the game table, games_per_device of them
+    unsigned int active;        // slots in use
+    struct device *device;
+};
+
+// sizing is a load time decision:
+//   insmod kernelgame.ko num_devices=4 games_per_device=1024
+// gives /dev/wtictactoe0..3 with 1024 games each
+static unsigned int num_devices = 1;
+module_param(num_devices, uint, 0444);
+MODULE_PARM_DESC(num_devices, "number of /dev nodes (1-256). 1 (default) is plain /dev/wtictactoe, more are /dev/wtictactoe0..N-1");
+static unsigned int games_per_device = 64;
+module_param(games_per_device, uint, 0444);
+MODULE_PARM_DESC(games_per_device, "game slots preallocated per node, opens past this get EBUSY (default 64)");
+
+static struct kg_node *kg_nodes;
+static struct dentry *kg_debugfs;
+
+// flip debug logging on with
+//   echo 1 > /sys/module/kernelgame/parameters/debug
+// (or insmod kernelgame.ko debug=1), see kg_debug_key in kg_engine.h
+static bool debug;
+
+static int kg_debug_set(const char *val, const struct kernel_param *kp) {
+    int ret = param_set_bool(val, kp);
+    if (ret)
+        return ret;
+    if (debug)
+        static_branch_enable(&kg_debug_key);
+    else
+        static_branch_disable(&kg_debug_key);
+    return 0;
+}
+
+static const struct kernel_param_ops kg_debug_ops = {
+    .set = kg_debug_set,
+    .get = param_get_bool,
+};
+module_param_cb(debug, &kg_debug_ops, &debug, 0644);
+MODULE_PARM_DESC(debug, "printk debug logging + [TESTAID] lines for testAid.sh (default off)");
+
+module_param_named(bot_mode, kg_bot_mode, int, 0644);
+MODULE_PARM_DESC(bot_mode, "0 = random bot (default), 1 = perfect bot, 2 = search bot (shared transposition cache)");
+
+// board geometry is fixed at load, every game on every node uses it
+//   insmod kernelgame.ko board_size=15 win_length=5
+static unsigned int board_size = 3;
+module_param(board_size, uint, 0444);
+MODULE_PARM_DESC(board_size, "board is board_size x board_size, 3-16 (default 3). past 3 the bot is always random");
+static unsigned int win_length = 3;
+module_param(win_length, uint, 0444);
+MODULE_PARM_DESC(win_length, "how many in a row wins, 3-board_size (default 3)");
+
+
+// game state in the uapi layout, for ioctl replies and the mmap page
+static void fill_ioc_state(const struct game_state *game, struct kg_ioc_state *out) {
+    out->x_mask = kg_classic() ? game->pieces[0] : 0;
+    out->o_mask = kg_classic() ? game->pieces[1] : 0;
+    out->current_piece = game->current_piece;
+    out->current_player = game->current_player;
+    out->game_started = game->game_started;
+    out->game_over = game->game_over;
+    out->winner = game->winner;
+}
+
+static void fill_ioc_board(const struct game_state *game, struct kg_ioc_board *out) {
+    unsigned int r;
+
+    BUILD_BUG_ON(KG_IOC_MAX_BOARD != KG_MAX_BOARD);
+    out->board_size = kg_board_size;
+    out->win_length = kg_win_length;
+    out->num_moves = game->num_moves;
+    for (r = 0; r < kg_board_size; r++) {
+        out->x_rows[r] = board_row(game, 0, r);
+        out->o_rows[r] = board_row(game, 1, r);
+    }
+}
+
+// consistent copy of the last published game without sess->lock, so board
+// reads never wait behind a move (or a slow BOT search) and every reader
+// renders from its own copy. a retry only happens if it raced a publish,
+// which is just a memcpy
+static void snapshot_game(struct kg_session *sess, struct game_state *game, struct kg_lines *lines) {
+    unsigned int seq;
+
+    do {
+        seq = read_seqcount_begin(&sess->published_seq);
+        game_copy(game, lines, &sess->published);
+    } while (read_seqcount_retry(&sess->published_seq, seq));
+}
+
+// next started game for a checkpoint dump, see kg_checkpoint.h. index is
+// node * games_per_device + slot. goes off the published copy like the
+// board ioctls, so a dump never waits on a move and never sees half of one
+bool kg_checkpoint_live(unsigned long *index, struct kg_ckpt_record *rec)
+{
+    unsigned long total = (unsigned long)num_devices * games_per_device;
+    struct game_state game;
+    struct kg_lines lines;
+
+    for (; *index < total; (*index)++) {
+        unsigned int n = *index / games_per_device, slot = *index % games_per_device;
+        struct kg_session *sess = kg_nodes[n].slots[slot];
+
+        // slots stay allocated until unload, an open or close racing this
+        // just means that game is in the dump or it isnt
+        if (!test_bit(slot, kg_nodes[n].used))
+            continue;
+        snapshot_game(sess, &game, &lines);
+        if (!game.game_started)
+            continue;
+        kg_checkpoint_encode(rec, READ_ONCE(sess->game_id), n, &game);
+        (*index)++;
+        return true;
+    }
+    return false;
+}
+
+// make the game visible to lockless readers, and copy it into the mmap page
+// if anyone has mapped it. both are seqcount style, seq is odd while its
+// being written. caller holds sess->lock so theres only ever one writer
+static void publish_state(struct kg_session *sess) {
+    struct kg_shared_state *shared = sess->shared;
+
+    write_seqcount_begin(&sess->published_seq);
+    game_copy(&sess->published, &sess->published_lines, &sess->game);
+    write_seqcount_end(&sess->published_seq);
+    if (!shared)
+        return;
+    WRITE_ONCE(shared->seq, shared->seq + 1);
+    smp_wmb();
+    fill_ioc_state(&sess->game, &shared->state);
+    fill_ioc_board(&sess->game, &shared->board);
+    smp_wmb();
+    WRITE_ONCE(shared->seq, shared->seq + 1);
+}
+
+static inline bool reply_unread(const struct kg_session *sess) {
+    return READ_ONCE(sess->reply_head) != READ_ONCE(sess->reply_tail);
+}
+
+// room for another command. the last slot is never given to a command, its
+// kept for a SIMULATE result so that one never has to be dropped
+static inline bool reply_room(const struct kg_session *sess) {
+    return READ_ONCE(sess->reply_head) - READ_ONCE(sess->reply_tail) < REPLY_QUEUE_LEN - 1;
+}
+
+// claim the next slot, caller holds sess->lock and checked theres room
+static struct kg_reply *reply_push(struct kg_session *sess, u32 seq, u8 kind) {
+    struct kg_reply *r = &sess->replies[sess->reply_head & (REPLY_QUEUE_LEN - 1)];
+
+    r->seq = seq;
+    r->kind = kind;
+    r->with_seq = sess->reply_seq;
+    // the reader only looks at it once head has moved past it, and both
+    // happen under sess->lock
+    sess->reply_head++;
+    sess->eof_sent = false;
+    return r;
+}
+
+// most a reply can render to, so kg_read knows if it still fits
+static size_t reply_max_len(const struct kg_reply *r) {
+    switch (r->kind) {
+    case KG_REPLY_BOARD:
+        return REPLY_LINE_MAX + kg_board_text_len;
+    case KG_REPLY_SIM:
+        return 2 * REPLY_LINE_MAX;
+    default:
+        return REPLY_LINE_MAX;
+    }
+}
+
+// reply text: the code name, BOARDs board or SIMULATEs result line, with
+// "<seq> " in front if the file asked for it (the board then goes under a
+// "<seq> BOARD" line). size has to be at least reply_max_len. the same
+// reply always gives the same text, kg_read counts on that to carry on
+// with one an earlier read only got part of
+static int render_reply(const struct kg_reply *r, char *buf, size_t size) {
+    int len = 0;
+
+    if (r->with_seq)
+        len = scnprintf(buf, size, "%u ", r->seq);
+    switch (r->kind) {
+    case KG_REPLY_BOARD:
+        if (r->with_seq)
+            len += scnprintf(buf + len, size - len, "BOARD\n");
+        len += print_rows_to_buffer(r->board.x_rows, r->board.o_rows, buf + len, size - len);
+        break;
+    case KG_REPLY_SIM:
+        len += scnprintf(buf + len, size - len, "SIMULATED %u X %llu O %llu D %llu %llu games/s\n",
+                         r->sim.games, r->sim.x_wins, r->sim.o_wins, r->sim.draws,
+                         kg_sim_games_per_sec(&r->sim));
+        break;
+    default:
+        len += scnprintf(buf + len, size - len, "%s\n", return_code_messages[r->code]);
+        break;
+    }
+    return len;
+}
+
+// runs on a kg_sim worker after the last game
+static void kg_sim_done(struct kg_sim *sim, void *data) {
+    struct kg_session *sess = data;
+
+    mutex_lock(&sess->lock);
+    sess->sim_running = false;
+    // commands never take the last slot, so theres always room for this
+    if (sess->sim_text)
+        kg_sim_result(sim, &reply_push(sess, sess->sim_seq, KG_REPLY_SIM)->sim);
+    mutex_unlock(&sess->lock);
+    wake_up_interruptible(&sess->wait);
+}
+
+// one SIMULATE per file at a time. returns a result code, or -errno if it
+// couldnt start at all. caller holds sess->lock
+static int start_simulation(struct kg_session *sess, u32 games, bool text, u32 seq) {
+    struct kg_sim *sim;
+
+    if (sess->sim_running)
+        return SIM_RUNNING;
+    // kg_sim_done is past the lock, so this only waits for it to return
+    kg_sim_free(sess->sim);
+    sess->sim = NULL;
+    sim = kg_sim_start(games, kg_sim_done, sess);
+    if (IS_ERR(sim))
+        return PTR_ERR(sim);
+    sess->sim = sim;
+    sess->sim_running = true;
+    sess->sim_text = text;
+    sess->sim_seq = seq;
+    return OK;
+}
+
+// called when cat-d
+// gives back the replies not read yet, oldest first, as many as fit. once
+// theyre all read there is one EOF (so cat finishes), after that read
+// blocks until the next reply, or returns -EAGAIN with O_NONBLOCK
+static ssize_t kg_read(struct file *filp, char __user *buf, size_t count, loff_t *pos)
+{
+    // arguments: *buf is the user-space buffer to fill, so data i copy to it is printed when cat-d
+    // count = max to read 
+    // so put wanted output into buf, dont forget to copy_to_user!
+    // ...your read logic...
+    struct kg_session *sess = filp->private_data;
+    char *out = sess->read_buf; // rendered replies, so copy_to_user runs unlocked
+    size_t limit = min(count, sizeof(sess->read_buf));
+    size_t bytes_read = 0;
+
+    kg_dbg("kg_read called\n");
+    // nothing to hand out, and it mustnt look like (or use up) the EOF
+    if (!count)
+        return 0;
+
+    while (!bytes_read) {
+        if (mutex_lock_interruptible(&sess->read_lock))
+            return -ERESTARTSYS;
+        if (mutex_lock_interruptible(&sess->lock)) {
+            mutex_unlock(&sess->read_lock);
+            return -ERESTARTSYS;
+        }
+        if (sess->reply_head == sess->reply_tail) {
+            // replies are consumed as theyre read
+            bool eof = !sess->eof_sent;
+
+            sess->eof_sent = true;
+            mutex_unlock(&sess->lock);
+            mutex_unlock(&sess->read_lock);
+            if (eof)
+                return 0;
+            if (filp->f_flags & O_NONBLOCK)
+                return -EAGAIN;
+            if (wait_event_interruptible(sess->wait, reply_unread(sess)))
+                return -ERESTARTSYS;
+            continue;
+        }
+
+        // whole replies while they fit, the first one can be the rest of a
+        // reply an earlier small read started. a long batch comes out over a
+        // few reads, cat keeps going
+        BUILD_BUG_ON(2 * REPLY_LINE_MAX > REPLY_TEXT_MAX);
+        while (sess->reply_head != sess->reply_tail && bytes_read < limit) {
+            const struct kg_reply *r = &sess->replies[sess->reply_tail & (REPLY_QUEUE_LEN - 1)];
+            size_t len, take;
+
+            if (bytes_read && bytes_read + reply_max_len(r) > sizeof(sess->read_buf))
+                break;
+            len = render_reply(r, out + bytes_read, sizeof(sess->read_buf) - bytes_read);
+            // cant happen, replies dont change once queued. skip it rather
+            // than underflow len, if that was the last one the outer loop
+            // goes back to waiting
+            if (WARN_ON_ONCE(sess->reply_off >= len)) {
+                sess->reply_off = 0;
+                sess->reply_tail++;
+                continue;
+            }
+            len -= sess->reply_off;
+            if (sess->reply_off)
+                memmove(out + bytes_read, out + bytes_read + sess->reply_off, len);
+            take = min(len, limit - bytes_read);
+            bytes_read += take;
+            if (take < len) {
+                sess->reply_off += take;
+                break;
+            }
+            sess->reply_off = 0;
+            sess->reply_tail++;
+        }
+        mutex_unlock(&sess->lock);
+        // writers waiting on a full queue
+        wake_up_interruptible(&sess->wait);
+        if (!bytes_read)
+            mutex_unlock(&sess->read_lock);
+    }
+
+    if (copy_to_user(buf, out, bytes_read)) {
+        mutex_unlock(&sess->read_lock);
+        return -EFAULT;
+    }
+    mutex_unlock(&sess->read_lock);
+
+    kg_dbg("tictactoe: read %zu bytes\n", bytes_read);
+
+    return bytes_read;
+}
+
+// readable when theres a reply to read, writable while the reply queue
+// has room for another command
+static __poll_t kg_poll(struct file *filp, poll_table *wait)
+{
+    struct kg_session *sess = filp->private_data;
+    __poll_t mask = 0;
+
+    poll_wait(filp, &sess->wait, wait);
+    if (reply_unread(sess))
+        mask |= EPOLLIN | EPOLLRDNORM;
+    if (reply_room(sess))
+        mask |= EPOLLOUT | EPOLLWRNORM;
+    return mask;
+}
+
+// run one command line and queue its reply (the board, for BOARD).
+// -ENOSPC if the reply queue is full, the command didnt run
+static int run_command_line(struct kg_session *sess, const char *command, bool too_long)
+{
+    struct parsed_command cmd;
+    struct kg_reply *reply;
+    int result, type;
+    u32 seq;
+
+    if (mutex_lock_interruptible(&sess->lock))
+        return -ERESTARTSYS;
+    if (!reply_room(sess)) {
+        mutex_unlock(&sess->lock);
+        return -ENOSPC;
+    }
+    seq = sess->next_seq;
+
+    kg_dbg("kg_write received command: %s\n", command);
+    trace_kg_command_received(command);
+    if (too_long) {
+        kg_dbg("input too long\n");
+        trace_kg_parse_error("line too long");
+        type = KG_CMD_INVALID;
+        result = DEV_INVALID_COMMAND;
+    } else {
+        result = process_command(&sess->game, command, &cmd);
+        type = cmd.type;
+    }
+    // the engine checked the count, the games run here
+    if (type == KG_CMD_SIMULATE && result == OK) {
+        result = start_simulation(sess, cmd.values[0], true, seq);
+        if (result < 0) {
+            mutex_unlock(&sess->lock);
+            return result;
+        }
+    }
+    publish_state(sess);
+    this_cpu_inc(kg_stats.commands[type]);
+    this_cpu_inc(kg_stats.results[result]);
+
+    // BOARDs reply is the board instead of OK
+    sess->next_seq++;
+    if (type == KG_CMD_BOARD) {
+        unsigned int r;
+
+        reply = reply_push(sess, seq, KG_REPLY_BOARD);
+        for (r = 0; r < kg_board_size; r++) {
+            reply->board.x_rows[r] = board_row(&sess->game, 0, r);
+            reply->board.o_rows[r] = board_row(&sess->game, 1, r);
+        }
+    } else {
+        reply = reply_push(sess, seq, KG_REPLY_CODE);
+        reply->code = result;
+    }
+    mutex_unlock(&sess->lock);
+    wake_up_interruptible(&sess->wait);
+
+    kg_dbg("process_command returned: %s\n", return_code_messages[result]);
+    return 0;
+}
+
+// run_command_line, but if the reply queue is full and nothing of this
+// write went in yet, wait for a reader to make room like a full pipe does
+// (EAGAIN with O_NONBLOCK). with some lines already in, -ENOSPC makes the
+// write short instead
+static int run_command_line_wait(struct file *filp, const char *command, bool too_long, bool accepted)
+{
+    struct kg_session *sess = filp->private_data;
+    int ret;
+
+    for (;;) {
+        ret = run_command_line(sess, command, too_long);
+        if (ret != -ENOSPC || accepted)
+            return ret;
+        if (filp->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        if (wait_event_interruptible(sess->wait, reply_room(sess)))
+            return -ERESTARTSYS;
+    }
+}
+
+// takes any number of newline separated commands and runs them in order,
+// every line queues one reply. if the reply queue fills up the write is
+// short (stops at the start of the line that didnt fit), read then write the rest
+static ssize_t kg_write_batch(struct file *filp, const char __user *buf, size_t count)
+{
+    char chunk[128];           // user data gets pulled in this much at a time
+    char command[BUFF_SIZE];   // Buffer to hold the command being built
+    size_t line_len = 0;
+    bool too_long = false;     // line didnt fit in command, rest is dropped
+    size_t off = 0;            // how much of buf has been copied in
+    size_t line_start = 0;     // where the line being built started in buf
+    size_t i, n;
+    int ret;
+
+    while (off < count) {
+        n = min(count - off, sizeof(chunk));
+        if (copy_from_user(chunk, buf + off, n)) {
+            kg_dbg("Failed to copy %zu bytes from user space\n", n); // any opener can trigger this, so not in dmesg by default
+            return line_start ? line_start : -EFAULT;
+        }
+        for (i = 0; i < n; i++) {
+            if (chunk[i] != '\n') {
+                if (line_len < sizeof(command) - 1)
+                    command[line_len++] = chunk[i];
+                else
+                    too_long = true;
+                continue;
+            }
+            // blank lines between commands are skipped
+            if (line_len > 0 || too_long) {
+                command[line_len] = '\0';
+                ret = run_command_line_wait(filp, command, too_long, line_start);
+                if (ret)
+                    return line_start ? line_start : ret;
+            }
+            line_start = off + i + 1;
+            line_len = 0;
+            too_long = false;
+        }
+        off += n;
+    }
+
+    // last command doesnt need a newline (echo -n)
+    if (line_len > 0 || too_long) {
+        command[line_len] = '\0';
+        ret = run_command_line_wait(filp, command, too_long, line_start);
+        if (ret)
+            return line_start ? line_start : ret;
+    }
+    return count;
+}
+
+// called when echo-ds
+static ssize_t kg_write(struct file *filp, const char __user *buf, size_t count, loff_t *pos)
+{
+    u64 start;
+    ssize_t ret;
+
+    // ...your write logic...
+    kg_dbg("kg_write called\n");
+    start = ktime_get_ns();
+    ret = kg_write_batch(filp, buf, count);
+
+    this_cpu_inc(kg_stats.write_lat[lat_bucket(start)]);
+    return ret;
+}
+
+// KG_IOC_SIMULATE starts a run, both hand back the latest one
+static long kg_ioctl_sim(struct kg_session *sess, unsigned int cmd, void __user *uarg)
+{
+    struct kg_sim_result res = { 0 };
+    struct kg_ioc_sim req;
+    int ret = OK;
+
+    memset(&req, 0, sizeof(req));
+    if (cmd == KG_IOC_SIMULATE && copy_from_user(&req, uarg, sizeof(req)))
+        return -EFAULT;
+
+    if (mutex_lock_interruptible(&sess->lock))
+        return -ERESTARTSYS;
+    if (cmd == KG_IOC_SIMULATE) {
+        if (req.games < 1 || req.games > KG_SIM_MAX_GAMES)
+            ret = DEV_INVALID_COMMAND;
+        else
+            ret = start_simulation(sess, req.games, false, 0);
+        if (ret < 0) {
+            mutex_unlock(&sess->lock);
+            return ret;
+        }
+        this_cpu_inc(kg_stats.commands[KG_CMD_SIMULATE]);
+        this_cpu_inc(kg_stats.results[ret]);
+    }
+    if (sess->sim)
+        kg_sim_result(sess->sim, &res);
+    mutex_unlock(&sess->lock);
+
+    req.code = ret;
+    req.running = res.running;
+    req.games = res.games;
+    req.played = res.played;
+    req.x_wins = res.x_wins;
+    req.o_wins = res.o_wins;
+    req.draws = res.draws;
+    req.elapsed_ns = res.elapsed_ns;
+    req.games_per_sec = kg_sim_games_per_sec(&res);
+    if (copy_to_user(uarg, &req, sizeof(req)))
+        return -EFAULT;
+    return 0;
+}
+
+// GET_BOARD and GET_BOARD_EX, from a snapshot so they never take sess->lock
+static long kg_ioctl_get_board(struct kg_session *sess, unsigned int cmd, void __user *uarg)
+{
+    struct game_state game;
+    struct kg_lines lines;
+    union {
+        struct kg_ioc_cmd req;
+        struct kg_ioc_board board;
+    } out;
+    size_t len;
+
+    snapshot_game(sess, &game, &lines);
+    memset(&out, 0, sizeof(out));
+    if (cmd == KG_IOC_GET_BOARD) {
+        out.req.code = OK;
+        fill_ioc_state(&game, &out.req.state);
+        len = sizeof(out.req);
+    } else {
+        fill_ioc_board(&game, &out.board);
+        len = sizeof(out.board);
+    }
+    this_cpu_inc(kg_stats.commands[KG_CMD_BOARD]);
+    this_cpu_inc(kg_stats.results[OK]);
+    if (copy_to_user(uarg, &out, len))
+        return -EFAULT;
+    return 0;
+}
+
+// take over a game restored from a checkpoint, see kg_checkpoint.c
+static long kg_ioctl_resume(struct kg_session *sess, void __user *uarg)
+{
+    __u64 id;
+    int ret;
+
+    if (get_user(id, (__u64 __user *)uarg))
+        return -EFAULT;
+    if (mutex_lock_interruptible(&sess->lock))
+        return -ERESTARTSYS;
+    // dont throw away a game thats being played
+    if (sess->game.game_started) {
+        ret = -EBUSY;
+    } else {
+        ret = kg_checkpoint_claim(id, sess->node - kg_nodes, &sess->game, &sess->lines);
+        if (!ret) {
+            WRITE_ONCE(sess->game_id, id);
+            publish_state(sess);
+            // a dump can find it live now, it can stop being parked
+            kg_checkpoint_claimed(id);
+        }
+    }
+    mutex_unlock(&sess->lock);
+    wake_up_interruptible(&sess->wait);
+    return ret;
+}
+
+// binary version of the text commands, see kernelgame_ioctl.h
+static long kg_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
+{
+    struct kg_session *sess = filp->private_data;
+    void __user *uarg = (void __user *)arg;
+    struct kg_ioc_cmd req;
+
+    // the uapi enum is what clients compare .code against
+    BUILD_BUG_ON((int)DEV_INVALID_COMMAND != (int)KG_DEV_INVALID_COMMAND);
+    BUILD_BUG_ON((int)SIM_RUNNING != (int)KG_SIM_RUNNING);
+
+    if (_IOC_TYPE(cmd) != KG_IOC_MAGIC)
+        return -ENOTTY;
+
+    if (cmd == KG_IOC_SIMULATE || cmd == KG_IOC_SIM_RESULT)
+        return kg_ioctl_sim(sess, cmd, uarg);
+    if (cmd == KG_IOC_GET_BOARD || cmd == KG_IOC_GET_BOARD_EX)
+        return kg_ioctl_get_board(sess, cmd, uarg);
+    if (cmd == KG_IOC_REPLY_SEQ) {
+        __u32 on;
+
+        if (get_user(on, (__u32 __user *)uarg))
+            return -EFAULT;
+        if (mutex_lock_interruptible(&sess->lock))
+            return -ERESTARTSYS;
+        sess->reply_seq = on;
+        mutex_unlock(&sess->lock);
+        return 0;
+    }
+    if (cmd == KG_IOC_GAME_ID)
+        return put_user(READ_ONCE(sess->game_id), (__u64 __user *)uarg);
+    if (cmd == KG_IOC_RESUME)
+        return kg_ioctl_resume(sess, uarg);
+
+    memset(&req, 0, sizeof(req));
+    if ((_IOC_DIR(cmd) & _IOC_WRITE) && copy_from_user(&req, uarg, sizeof(req)))
+        return -EFAULT;
+
+    if (mutex_lock_interruptible(&sess->lock))
+        return -ERESTARTSYS;
+    switch (cmd) {
+    case KG_IOC_START:
+        req.code = game_start(&sess->game, req.piece);
+        this_cpu_inc(kg_stats.commands[KG_CMD_START]);
+        break;
+    case KG_IOC_PLAY:
+        // 1 based like PLAY, 0 wraps to -1 and is OUT_OF_BOUNDS
+        req.code = game_play(&sess->game, (int)req.row - 1, (int)req.col - 1);
+        this_cpu_inc(kg_stats.commands[KG_CMD_PLAY]);
+        break;
+    case KG_IOC_BOT:
+        req.code = game_bot(&sess->game);
+        this_cpu_inc(kg_stats.commands[KG_CMD_BOT]);
+        break;
+    case KG_IOC_RESET:
+        req.code = game_reset(&sess->game);
+        this_cpu_inc(kg_stats.commands[KG_CMD_RESET]);
+        break;
+    default:
+        mutex_unlock(&sess->lock);
+        return -ENOTTY;
+    }
+    this_cpu_inc(kg_stats.results[req.code]);
+    fill_ioc_state(&sess->game, &req.state);
+    publish_state(sess);
+    mutex_unlock(&sess->lock);
+    wake_up_interruptible(&sess->wait);
+
+    kg_dbg("kg_ioctl %u returned: %s\n", _IOC_NR(cmd), return_code_messages[req.code]);
+    if (copy_to_user(uarg, &req, sizeof(req)))
+        return -EFAULT;
+    return 0;
+}
+
+// map the read only kg_shared_state page (see kernelgame_ioctl.h), so
+// dashboards can watch the game with no syscalls at all
+static int kg_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+    struct kg_session *sess = filp->private_data;
+
+    if (vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start != PAGE_SIZE)
+        return -EINVAL;
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+    // and no mprotect'ing it writable later either
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_clear(vma, VM_MAYWRITE);
+#else
+    vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+    if (mutex_lock_interruptible(&sess->lock))
+        return -ERESTARTSYS;
+    if (!sess->shared) {
+        sess->shared = (struct kg_shared_state *)get_zeroed_page(GFP_KERNEL);
+        if (!sess->shared) {
+            mutex_unlock(&sess->lock);
+            return -ENOMEM;
+        }
+        sess->shared->version = KG_SHARED_VERSION;
+        publish_state(sess);
+    }
+    mutex_unlock(&sess->lock);
+
+    return vm_insert_page(vma, vma->vm_start, virt_to_page(sess->shared));
+}
+
+
+// grab a free slot from the nodes game table, NULL when its full
+static struct kg_session *claim_slot(struct kg_node *node) {
+    unsigned long idx;
+
+    spin_lock(&node->lock);
+    idx = find_first_zero_bit(node->used, games_per_device);
+    if (idx >= games_per_device) {
+        spin_unlock(&node->lock);
+        return NULL;
+    }
+    __set_bit(idx, node->used);
+    node->active++;
+    spin_unlock(&node->lock);
+    return node->slots[idx];
+}
+
+static void release_slot(struct kg_session *sess) {
+    struct kg_node *node = sess->node;
+
+    spin_lock(&node->lock);
+    __clear_bit(sess->slot, node->used);
+    node->active--;
+    spin_unlock(&node->lock);
+}
+
+static int kg_release(struct inode *inode, struct file *filp) {
+    // game goes away with the file. last reference is gone by now so no
+    // reader or writer can still be holding the lock
+    struct kg_session *sess = filp->private_data;
+
+    kg_dbg("kg_release called\n");
+    // a SIMULATE still going is stopped, its workers point at this session
+    kg_sim_free(sess->sim);
+    // any mapping holds a reference to the file, so the page is unmapped by now
+    if (sess->shared)
+        free_page((unsigned long)sess->shared);
+    release_slot(sess);
+    filp->private_data = NULL;
+    return 0; // success
+}
+// open
+static int kg_open(struct inode *inode, struct file *filp) {
+    unsigned int minor = iminor(inode);
+    struct kg_session *sess;
+
+    kg_dbg("kg_open called\n");
+    // register_chrdev hands us all 256 minors, someone could mknod one we didnt create
+    if (minor >= num_devices)
+        return -ENODEV;
+
+    // every open gets its own game, so openers dont trample each other
+    sess = claim_slot(&kg_nodes[minor]);
+    if (!sess) {
+        kg_dbg("node %u is full\n", minor);
+        return -EBUSY;
+    }
+
+    // lock and wait queue were set up once by the slab constructor
+    game_init(&sess->game, &sess->lines);
+    sess->reply_head = 0;
+    sess->reply_tail = 0;
+    sess->reply_off = 0;
+    sess->next_seq = 1;
+    sess->reply_seq = false;
+    sess->eof_sent = true; // nothing to say yet, so a read waits for the first reply
+    sess->shared = NULL;
+    sess->sim = NULL;
+    sess->sim_running = false;
+    WRITE_ONCE(sess->game_id, get_random_u64());
+    // nobody else can see this slot yet, the lock is just for the seqcount
+    mutex_lock(&sess->lock);
+    publish_state(sess);
+    mutex_unlock(&sess->lock);
+    filp->private_data = sess;
+
+    // reply is consumed by read, file position doesnt mean anything
+    return stream_open(inode, filp);
+} 
+
+/**
+ * Structure to represent what happens when you read and write to your driver.
+ *
+ *  Note: you have to pass this in when registering your character driver.
+ *        initially, this is not done for you.
+ */
+static struct file_operations char_driver_ops = {
+  .owner  = THIS_MODULE,
+  .read   = kg_read,
+  .write  = kg_write,
+  .poll   = kg_poll,
+  .mmap   = kg_mmap,
+  .unlocked_ioctl = kg_ioctl,
+  .compat_ioctl = compat_ptr_ioctl, // struct has the same layout on 32 bit
+  .open  = kg_open,
+  .release = kg_release,
+};
+
+// You only need to modify the name here.
+static struct file_system_type kernel_game_driver = {
+  .name     = "tictactoegame",
+  .fs_flags = O_RDWR
+};
+
+
+// sum the per cpu stats, plus live sessions from the node tables
+static int kg_stats_show(struct seq_file *m, void *unused) {
+  struct kg_stats total = {};
+  unsigned int active = 0;
+  u64 hit_rate;
+  int cpu, i;
+
+  for_each_possible_cpu(cpu) {
+    const struct kg_stats *st = per_cpu_ptr(&kg_stats, cpu);
+
+    for (i = 0; i < KG_CMD_COUNT; i++)
+      total.commands[i] += st->commands[i];
+    for (i = 0; i < KG_RESULT_COUNT; i++)
+      total.results[i] += st->results[i];
+    total.games_won += st->games_won;
+    total.games_lost += st->games_lost;
+    total.games_drawn += st->games_drawn;
+    for (i = 0; i < KG_LAT_BUCKETS; i++) {
+      total.write_lat[i] += st->write_lat[i];
+      total.bot_lat[i] += st->bot_lat[i];
+    }
+    total.tt_lookups += st->tt_lookups;
+    total.tt_hits += st->tt_hits;
+    total.sim_games += st->sim_games;
+  }
+  for (i = 0; i < num_devices; i++) {
+    spin_lock(&kg_nodes[i].lock);
+    active += kg_nodes[i].active;
+    spin_unlock(&kg_nodes[i].lock);
+  }
+
+  seq_printf(m, "active_sessions %u\n", active);
+  for (i = 0; i < KG_CMD_COUNT; i++)
+    seq_printf(m, "command_%s %llu\n", kg_cmd_names[i], total.commands[i]);
+  for (i = 0; i < KG_RESULT_COUNT; i++)
+    seq_printf(m, "result_%s %llu\n", return_code_messages[i], total.results[i]);
+  seq_printf(m, "games_won %llu\ngames_lost %llu\ngames_drawn %llu\n",
+             total.games_won, total.games_lost, total.games_drawn);
+  seq_printf(m, "history_dropped %llu\n", kg_history_dropped());
+  seq_printf(m, "sim_games %llu\n", total.sim_games);
+  seq_printf(m, "checkpoint_parked %u\n", kg_checkpoint_parked());
+  // hit rate in hundredths of a percent, no floats in here
+  hit_rate = total.tt_lookups ? div64_u64(total.tt_hits * 10000, total.tt_lookups) : 0;
+  seq_printf(m, "tt_lookups %llu\ntt_hits %llu\ntt_hit_rate %llu.%02llu%%\n",
+             total.tt_lookups, total.tt_hits, hit_rate / 100, hit_rate % 100);
+  // only buckets that have something, "lo-hi" in ns
+  seq_puts(m, "write_latency_ns\n");
+  for (i = 0; i < KG_LAT_BUCKETS; i++) {
+    if (total.write_lat[i])
+      seq_printf(m, "  %llu-%llu %llu\n", 1ULL << i, (2ULL << i) - 1, total.write_lat[i]);
+  }
+  seq_puts(m, "bot_latency_ns\n");
+  for (i = 0; i < KG_LAT_BUCKETS; i++) {
+    if (total.bot_lat[i])
+      seq_printf(m, "  %llu-%llu %llu\n", 1ULL << i, (2ULL << i) - 1, total.bot_lat[i]);
+  }
+  return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(kg_stats);
+
+// tear down the first count nodes (devices + game tables)
+static void kg_destroy_nodes(unsigned int count) {
+  unsigned int i, j;
+
+  for (i = 0; i < count; i++) {
+    if (kg_nodes[i].device)
+      device_destroy(kg_class, MKDEV(major, i));
+    bitmap_free(kg_nodes[i].used);
+    if (kg_nodes[i].slots) {
+      for (j = 0; j < games_per_device; j++) {
+        if (kg_nodes[i].slots[j])
+          kmem_cache_free(kg_session_cache, kg_nodes[i].slots[j]);
+      }
+    }
+    kvfree(kg_nodes[i].slots);
+  }
+  kfree(kg_nodes);
+  kg_nodes = NULL;
+}
+
+// runs once per object when the slab is populated, not per open
+static void kg_session_ctor(void *obj) {
+  struct kg_session *sess = obj;
+
+  mutex_init(&sess->lock);
+  mutex_init(&sess->read_lock);
+  seqcount_mutex_init(&sess->published_seq, &sess->lock);
+  init_waitqueue_head(&sess->wait);
+}
+
+/**
+ * Initializes and Registers your Module. 
+ * You should be registering a character device,
+ * and initializing any memory for your project.
+ * Note: this is all kernel-space!
+ * 
+ */
+static int __init kernel_game_init(void) {
+  unsigned int i, j;
+  int ret;
+
+  printk(KERN_INFO "kern game init called - will :3\n");
+  if (num_devices < 1 || num_devices > 256 || games_per_device < 1) {
+      printk(KERN_ERR "num_devices must be 1-256 and games_per_device at least 1\n");
+      return -EINVAL;
+  }
+  ret = kg_engine_setup(board_size, win_length);
+  if (ret) {
+      printk(KERN_ERR "board_size must be 3-%u and win_length 3-board_size\n", KG_MAX_BOARD);
+      return ret;
+  }
+  // -- register your character device here --
+
+  major = register_chrdev(0, DEVICE_NAME, &char_driver_ops);
+  if (major < 0) {
+      printk(KERN_ALERT "FAIL TO REGISTER\n");
+      return major;
+  }
+  printk(KERN_INFO "registered with major number %d\n", major);
+  
+  // class thing?
+  kg_class = class_create(THIS_MODULE, "wtictactoe_class");
+  if (IS_ERR(kg_class)) {
+      ret = PTR_ERR(kg_class);
+      goto fail_class;
+  }
+
+  kg_session_cache = kmem_cache_create("kg_session", sizeof(struct kg_session), 0,
+                                       SLAB_HWCACHE_ALIGN, kg_session_ctor);
+  if (!kg_session_cache) {
+      ret = -ENOMEM;
+      goto fail_cache;
+  }
+
+  kg_nodes = kcalloc(num_devices, sizeof(*kg_nodes), GFP_KERNEL);
+  if (!kg_nodes) {
+      ret = -ENOMEM;
+      goto fail_nodes;
+  }
+  for (i = 0; i < num_devices; i++) {
+      struct kg_node *node = &kg_nodes[i];
+
+      spin_lock_init(&node->lock);
+      node->slots = kvcalloc(games_per_device, sizeof(*node->slots), GFP_KERNEL);
+      node->used = bitmap_zalloc(games_per_device, GFP_KERNEL);
+      if (!node->slots || !node->used) {
+          ret = -ENOMEM;
+          goto fail_devices;
+      }
+      for (j = 0; j < games_per_device; j++) {
+          node->slots[j] = kmem_cache_alloc(kg_session_cache, GFP_KERNEL);
+          if (!node->slots[j]) {
+              ret = -ENOMEM;
+              goto fail_devices;
+          }
+          node->slots[j]->node = node;
+          node->slots[j]->slot = j;
+      }
+      // one node keeps the old name so existing scripts still work
+      if (num_devices == 1)
+          node->device = device_create(kg_class, NULL, MKDEV(major, i), NULL, DEVICE_NAME);
+      else
+          node->device = device_create(kg_class, NULL, MKDEV(major, i), NULL, DEVICE_NAME "%u", i);
+      if (IS_ERR(node->device)) {
+          ret = PTR_ERR(node->device);
+          node->device = NULL;
+          goto fail_devices;
+      }
+  }
+  printk(KERN_INFO "%u device(s) created, %u games each\n", num_devices, games_per_device);
+
+  // board starts empty (both bitboards 0), done per session from new_game
+
+  ret = kg_history_init();
+  if (ret)
+      goto fail_devices;
+
+  ret = kg_sim_init();
+  if (ret)
+      goto fail_history;
+
+  // restored games can wait for as many files as could hold them
+  ret = kg_checkpoint_init(num_devices, num_devices * games_per_device);
+  if (ret)
+      goto fail_sim;
+
+  ret = register_filesystem(&kernel_game_driver);
+  if (ret)
+      goto fail_checkpoint;
+
+  // debugfs is optional, nothing breaks if it isnt there
+  kg_debugfs = debugfs_create_dir("wtictactoe", NULL);
+  debugfs_create_file("stats", 0444, kg_debugfs, NULL, &kg_stats_fops);
+  // reading it drains the finished games, so only root
+  debugfs_create_file("history", 0400, kg_debugfs, NULL, &kg_history_fops);
+  // every game on the box, and writing it makes games, so only root
+  debugfs_create_file("checkpoint", 0600, kg_debugfs, NULL, &kg_checkpoint_fops);
+  return 0;
+
+fail_checkpoint:
+  kg_checkpoint_exit();
+fail_sim:
+  kg_sim_exit();
+fail_history:
+  kg_history_exit();
+fail_devices:
+  // i is the node that failed, its half set up so include it
+  kg_destroy_nodes(min(i + 1, num_devices));
+fail_nodes:
+  kmem_cache_destroy(kg_session_cache);
+fail_cache:
+  class_destroy(kg_class);
+fail_class:
+  unregister_chrdev(major, DEVICE_NAME);
+  return ret;
+}
+
+/**
+ * Cleans up memory and unregisters your module.
+ *  - cleanup: freeing memory.
+ *  - unregister: remove your entry from /dev.
+ */
+static void __exit kernel_game_exit(void) {
+  printk(KERN_INFO "kern game exit called - will :3\n");
+  // -- cleanup memory --
+  debugfs_remove_recursive(kg_debugfs);
+  unregister_filesystem(&kernel_game_driver);
+  kg_checkpoint_exit();
+  kg_sim_exit();
+  kg_history_exit();
+  /// class, devices and game tables. every file is closed by now (module refcount)
+  kg_destroy_nodes(num_devices);
+  kmem_cache_destroy(kg_session_cache);
+  class_destroy(kg_class);
+
+  unregister_chrdev(major, DEVICE_NAME);
+  
+
+  // -- unregister your device driver here --
+  
+  return;
+}
+
+module_init(kernel_game_init);  // defines entry point function to the module, called when loaded
+module_exit(kernel_game_exit);  // 
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Will Capitos");
+MODULE_DESCRIPTION("a tic tac toe game implemented as a linux kernel module!");
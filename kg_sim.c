@@ -0,0 +1,156 @@
+// SIMULATE: N bot vs bot games, played in the kernel so the module is its
+// own load generator.
+//
+// the games get split evenly over the online cpus, one work item per cpu on
+// a per cpu (bound) workqueue, so a run shows how the engine scales with
+// cores. every chunk plays its games on its own stack board and keeps its
+// counts local, the only shared writes are one atomic add per chunk at the
+// end (and the search bot cache, if thats the bot). the chunk that finishes
+// last stamps the time and calls done. the workqueue is WQ_CPU_INTENSIVE
+// since a chunk can run for seconds, it still cond_resched()s every game
+#include <linux/kernel.h>
+#include <linux/atomic.h>
+#include <linux/cpu.h>
+#include <linux/err.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+#include "kg_engine.h"
+#include "kg_sim.h"
+
+struct kg_sim_chunk {
+    struct work_struct work;
+    struct kg_sim *sim;
+    u32 games;
+};
+
+struct kg_sim {
+    u32 games;
+    int bot_mode;         // kg_bot_mode when it started, for every game
+    bool stop;            // kg_sim_free wants the workers gone
+    atomic_t pending;     // chunks still running
+    atomic64_t played;
+    atomic64_t x_wins;
+    atomic64_t o_wins;
+    atomic64_t draws;
+    u64 start_ns;
+    u64 elapsed_ns;       // set by the last chunk, only read once finished is
+    int finished;         // set (release) after elapsed_ns, int so its one store on 32 bit too
+    void (*done)(struct kg_sim *sim, void *data);
+    void *data;
+    unsigned int nr_chunks;
+    struct kg_sim_chunk chunks[];
+};
+
+static struct workqueue_struct *kg_sim_wq;
+
+static void kg_sim_work(struct work_struct *work) {
+    struct kg_sim_chunk *chunk = container_of(work, struct kg_sim_chunk, work);
+    struct kg_sim *sim = chunk->sim;
+    u64 wins[3] = { 0, 0, 0 }; // X, O, draw
+    u32 i;
+
+    for (i = 0; i < chunk->games && !READ_ONCE(sim->stop); i++) {
+        switch (kg_self_play(sim->bot_mode)) {
+        case 'X':
+            wins[0]++;
+            break;
+        case 'O':
+            wins[1]++;
+            break;
+        default:
+            wins[2]++;
+            break;
+        }
+        this_cpu_inc(kg_stats.sim_games);
+        cond_resched();
+    }
+    atomic64_add(wins[0], &sim->x_wins);
+    atomic64_add(wins[1], &sim->o_wins);
+    atomic64_add(wins[2], &sim->draws);
+    atomic64_add(i, &sim->played);
+
+    // counts above are in before anyone sees pending hit 0
+    if (atomic_dec_and_test(&sim->pending)) {
+        sim->elapsed_ns = max_t(u64, ktime_get_ns() - sim->start_ns, 1);
+        smp_store_release(&sim->finished, 1);
+        if (!READ_ONCE(sim->stop))
+            sim->done(sim, sim->data);
+    }
+}
+
+struct kg_sim *kg_sim_start(u32 games, void (*done)(struct kg_sim *sim, void *data), void *data) {
+    unsigned int nr, i = 0;
+    struct kg_sim *sim;
+    int cpu;
+
+    // cpus cant come or go between counting them and queueing on them
+    cpus_read_lock();
+    nr = min_t(unsigned int, num_online_cpus(), games);
+    sim = kzalloc(struct_size(sim, chunks, nr), GFP_KERNEL);
+    if (!sim) {
+        cpus_read_unlock();
+        return ERR_PTR(-ENOMEM);
+    }
+    sim->games = games;
+    sim->bot_mode = READ_ONCE(kg_bot_mode);
+    sim->done = done;
+    sim->data = data;
+    sim->nr_chunks = nr;
+    atomic_set(&sim->pending, nr);
+    sim->start_ns = ktime_get_ns();
+    for_each_online_cpu(cpu) {
+        struct kg_sim_chunk *chunk = &sim->chunks[i];
+
+        if (i == nr)
+            break;
+        chunk->sim = sim;
+        // first games % nr chunks take one extra
+        chunk->games = games / nr + (i < games % nr);
+        INIT_WORK(&chunk->work, kg_sim_work);
+        queue_work_on(cpu, kg_sim_wq, &chunk->work);
+        i++;
+    }
+    cpus_read_unlock();
+    return sim;
+}
+
+void kg_sim_result(const struct kg_sim *sim, struct kg_sim_result *res) {
+    // finished is set after every chunks counts and elapsed_ns, so it goes first
+    res->running = !smp_load_acquire(&sim->finished);
+    res->elapsed_ns = res->running ? 0 : sim->elapsed_ns;
+    res->games = sim->games;
+    res->played = atomic64_read(&sim->played);
+    res->x_wins = atomic64_read(&sim->x_wins);
+    res->o_wins = atomic64_read(&sim->o_wins);
+    res->draws = atomic64_read(&sim->draws);
+}
+
+u64 kg_sim_games_per_sec(const struct kg_sim_result *res) {
+    if (!res->elapsed_ns)
+        return 0;
+    return div64_u64(res->played * NSEC_PER_SEC, res->elapsed_ns);
+}
+
+void kg_sim_free(struct kg_sim *sim) {
+    unsigned int i;
+
+    if (!sim)
+        return;
+    WRITE_ONCE(sim->stop, true);
+    for (i = 0; i < sim->nr_chunks; i++)
+        cancel_work_sync(&sim->chunks[i].work);
+    kfree(sim);
+}
+
+int kg_sim_init(void) {
+    kg_sim_wq = alloc_workqueue("kg_sim", WQ_CPU_INTENSIVE, 0);
+    return kg_sim_wq ? 0 : -ENOMEM;
+}
+
+void kg_sim_exit(void) {
+    destroy_workqueue(kg_sim_wq);
+}
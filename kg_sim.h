@@ -0,0 +1,30 @@
+// SIMULATE, bot vs bot games run on a worker pool, see kg_sim.c
+#ifndef KG_SIM_H
+#define KG_SIM_H
+
+#include <linux/types.h>
+
+struct kg_sim;
+
+struct kg_sim_result {
+    bool running;
+    u32 games;         // asked for
+    u64 played;        // finished so far
+    u64 x_wins;
+    u64 o_wins;
+    u64 draws;
+    u64 elapsed_ns;    // start to the last game, 0 while running
+};
+
+// done runs once, from a worker, after the last game. not at all if the
+// run got freed first
+struct kg_sim *kg_sim_start(u32 games, void (*done)(struct kg_sim *sim, void *data), void *data);
+void kg_sim_result(const struct kg_sim *sim, struct kg_sim_result *res);
+u64 kg_sim_games_per_sec(const struct kg_sim_result *res);
+// stops it if its still going and waits for the workers, sim can be NULL
+void kg_sim_free(struct kg_sim *sim);
+
+int kg_sim_init(void);
+void kg_sim_exit(void);
+
+#endif
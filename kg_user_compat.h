@@ -0,0 +1,65 @@
+// just enough of the kernel for kg_engine.c to build as a normal userspace
+// library (make libkgengine.a). only included when __KERNEL__ isnt defined.
+// tracepoints and debug logging compile away, per cpu stats become plain
+// globals (the library is single threaded), the rng is a xorshift
+#ifndef KG_USER_COMPAT_H
+#define KG_USER_COMPAT_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define BUILD_BUG_ON(cond) ((void)sizeof(char[1 - 2 * !!(cond)]))
+#define READ_ONCE(x) (*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, val) (*(volatile __typeof__(x) *)&(x) = (val))
+#define min_t(type, a, b) ((type)(a) < (type)(b) ? (type)(a) : (type)(b))
+
+#define hweight16(w) __builtin_popcount((u16)(w))
+#define __ffs(w) ((unsigned long)__builtin_ctzl(w))
+#define fls(w) ((w) ? 32 - __builtin_clz(w) : 0)
+#define ilog2(n) (63 - __builtin_clzll(n))
+
+#define DEFINE_PER_CPU(type, name) type name
+#define DECLARE_PER_CPU(type, name) extern type name
+#define this_cpu_inc(x) ((x)++)
+
+#define DEFINE_STATIC_KEY_FALSE(name) bool name
+#define DECLARE_STATIC_KEY_FALSE(name) extern bool name
+#define static_branch_unlikely(key) false
+
+#define KERN_INFO ""
+#define printk(...) do { } while (0)
+
+#define trace_kg_command_received(...) do { } while (0)
+#define trace_kg_move_applied(...) do { } while (0)
+#define trace_kg_game_over(...) do { } while (0)
+#define trace_kg_parse_error(...) do { } while (0)
+
+static inline u64 ktime_get_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// bounded pick in [0, ceil), same contract as the kernel helper
+static inline u32 get_random_u32_below(u32 ceil) {
+    static u32 state = 2463534242u;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (u32)(((uint64_t)state * ceil) >> 32);
+}
+
+#endif
@@ -1,18 +1,15 @@
+# each open of /dev/wtictactoe is its own game, so hold one fd open for the whole demo
+# writes are applied before echo returns and cat reads that reply, so no sleeps needed
+exec 3<>/dev/wtictactoe
 #start
-echo "START X" > /dev/wtictactoe
-sleep 0.5
-cat /dev/wtictactoe
-sleep 0.5
+echo "START X" >&3
+cat <&3
 # play piece at 2 2
-echo "PLAY 2 2" > /dev/wtictactoe
-sleep 0.5
-cat /dev/wtictactoe
-sleep 0.5
+echo "PLAY 2 2" >&3
+cat <&3
 # bot play
-echo "BOT" > /dev/wtictactoe
-sleep 0.5
+echo "BOT" >&3
 # figure out where the bot played by checking the board
-echo "BOARD" > /dev/wtictactoe
-sleep 0.5
-cat /dev/wtictactoe
-sleep 0.5
+echo "BOARD" >&3
+cat <&3
+exec 3<&-
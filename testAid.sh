@@ -67,10 +67,14 @@ INVALID_COMMANDS=(
 
 # adding custom log identifiers to aid in this test
 LOG_PREFIX="[TESTAID]"
+# [TESTAID] lines (and all the other debug printk) are off unless the debug switch is on
+echo 1 | sudo tee /sys/module/kernelgame/parameters/debug > /dev/null
+# every open of the device is its own game, so keep one fd open for all the commands
+exec 3>/dev/wtictactoe
 # will then have a [PASS] or [FAIL], + reason for fail. use these to check each test case resolves correctly.
 # valid commands:
 for cmd in "${VALID_COMMANDS[@]}"; do
-    echo "$cmd" > /dev/wtictactoe
+    echo "$cmd" >&3
     # wait a moment for the kernel to process the command
     sleep 0.5
     # check dmesg for the expected output using fixed-string matching to avoid regex pitfalls
@@ -85,7 +89,7 @@ done
 
 # invalid commands:
 for cmd in "${INVALID_COMMANDS[@]}"; do
-    echo "$cmd" > /dev/wtictactoe
+    echo "$cmd" >&3
     # wait a moment for the kernel to process the command
     sleep 0.5
     # check dmesg for the expected output using fixed-string matching to avoid regex pitfalls
@@ -97,3 +101,5 @@ for cmd in "${INVALID_COMMANDS[@]}"; do
         echo -e "\e[31m[FAIL]\e[0m (invalid) $cmd"
     fi
 done
+
+exec 3>&-